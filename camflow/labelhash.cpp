@@ -0,0 +1,37 @@
+//
+//  labelhash.cpp
+//  graphchi_xcode
+//
+
+#include <algorithm>
+#include "labelhash.hpp"
+#include "util/qsort.hpp"
+
+static inline uint64_t mix_label(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+uint64_t hash_labels(std::vector<uint64_t>& labels) {
+    smallSort(labels.data(), (int)labels.size());
+    uint64_t h = 0x9e3779b97f4a7c15ULL ^ (labels.size() * 0x87c37b91114253d5ULL);
+    for (size_t i = 0; i < labels.size(); i++) {
+        h ^= mix_label(labels[i]);
+        h = (h << 27 | h >> 37) * 0x4cf5ad432745937fULL + 0x52dce729;
+    }
+    return mix_label(h);
+}
+
+bool label_collisions::check(uint64_t label, const std::vector<uint64_t>& multiset) {
+    std::lock_guard<std::mutex> guard(this->lock);
+    std::pair<std::map<uint64_t, std::vector<uint64_t>>::iterator, bool> rst;
+    rst = this->multisets.insert(std::make_pair(label, multiset));
+    if (rst.second || rst.first->second == multiset)
+        return true;
+    this->ncollisions++;
+    return false;
+}
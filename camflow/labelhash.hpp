@@ -0,0 +1,40 @@
+//
+//  labelhash.hpp
+//  graphchi_xcode
+//
+
+#ifndef labelhash_hpp
+#define labelhash_hpp
+
+#include <stdint.h>
+#include <vector>
+#include <map>
+#include <mutex>
+
+//64-bit label of a multiset of labels: the labels are sorted in place and mixed one word at a time (a
+//non-cryptographic hash in the style of murmur's 64-bit finalizer), so equal multisets get equal labels
+uint64_t hash_labels(std::vector<uint64_t>& labels);
+
+//Optional check of hash_labels: keeps the multiset behind every label it is given and counts the labels that are
+//given for two different multisets
+class label_collisions {
+public:
+
+    //record that label compresses the (sorted) multiset; returns false if it compressed another one before
+    bool check(uint64_t label, const std::vector<uint64_t>& multiset);
+
+    long collisions() const {
+        return this->ncollisions;
+    }
+
+private:
+
+    std::map<uint64_t, std::vector<uint64_t>> multisets;
+
+    std::mutex lock;
+
+    long ncollisions = 0;
+};
+
+#include "labelhash.cpp"
+#endif /* labelhash_hpp */
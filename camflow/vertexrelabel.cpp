@@ -6,10 +6,21 @@
 //
 //
 
-//Use dynamic edge data
 //Income data format should be in the format: src_id dst_id src_type:dst_type:edge_type
 //types must be integers in the form of strings. For example, mmap_write should be "12" (string)
+
+//Integer labels (the default): vertex and edge data are 64-bit labels (POD), and a new label is the hash of the multiset
+//of the labels it is made of (labelhash.hpp), so the data does not grow with every iteration. The collisions of the
+//hash are counted when the program is run with verify_labels 1
+//Build with -DINTEGER_LABELS=0 for string labels: the labels joined with commas, in dynamic edge data
+#ifndef INTEGER_LABELS
+#define INTEGER_LABELS 1
+#endif
+
+#if !INTEGER_LABELS
+//Use dynamic edge data
 #define DYNAMICEDATA 1
+#endif
 
 #include <string>
 #include <iostream>
@@ -21,6 +32,9 @@
 #include <vector>
 #include <sstream>
 #include "graphchi_basic_includes.hpp"
+#if INTEGER_LABELS
+#include "labelhash.hpp"
+#endif
 
 using namespace graphchi;
 
@@ -30,9 +44,134 @@ using namespace graphchi;
  */
 
 
+#if INTEGER_LABELS
+
+typedef uint64_t VertexDataType;
+
+//labels of the source and the destination of an edge (the edge type is not used by the relabeling)
+struct edge_labels {
+    uint64_t src;
+    uint64_t dst;
+};
+
+typedef edge_labels EdgeDataType;
+
+// Parse the type value in the file: the vertex types are the first labels
+void parse(edge_labels &x, const char * s) {
+    char * end;
+    x.src = strtoull(s, &end, 10);
+    if (*end != ':')
+        logstream(LOG_FATAL) << "Destination Type info does not exist" << std::endl;
+    assert(*end == ':');
+    x.dst = strtoull(end + 1, &end, 10);
+    if (*end != ':')
+        logstream(LOG_FATAL) << "Edge Type info does not exist" << std::endl;
+    assert(*end == ':');
+}
+
+#else
+
 typedef std::string VertexDataType;
 typedef chivector<std::string> EdgeDataType;//src_type dst_type edge_type
 
+#endif
+
+#if INTEGER_LABELS
+
+/**
+ * Relabeling with integer labels: the new label of a vertex is the hash of the multiset of its label and the labels of
+ * all of its neighbors
+ */
+struct VertexRelabel : public GraphChiProgram<VertexDataType, EdgeDataType> {
+    
+    std::map<uint64_t, int> label_map;
+    std::mutex map_lock;
+    label_collisions * verify;//NULL unless the labels are verified
+    
+    VertexRelabel(label_collisions * verify) : verify(verify) {}
+    
+    void updateOrInsert(uint64_t label) {
+        std::pair<std::map<uint64_t, int>::iterator, bool> rst;
+        rst = label_map.insert(std::pair<uint64_t, int>(label, 1));
+        if (rst.second == false)
+            rst.first->second = rst.first->second + 1;
+        return;
+    }
+    
+    void print_map () {
+        std::map<uint64_t, int>::iterator map_itr;
+        for (map_itr = label_map.begin(); map_itr != label_map.end(); map_itr++)
+            std::cout << map_itr->first << ":" << map_itr->second << std::endl;
+    }
+    
+    /**
+     *  Vertex update function.
+     */
+    void update(graphchi_vertex<VertexDataType, EdgeDataType> &vertex, graphchi_context &gcontext) {
+        //an id that is not a vertex of the graph (ids do not have to be contiguous) has no type
+        if (vertex.num_edges() == 0)
+            return;
+        uint64_t label;
+        if (gcontext.iteration == 0) {
+            // First for each vertex, set its label as its type, from any outedge (src) or inedge (dst)
+            if (vertex.num_outedges() > 0)
+                label = vertex.outedge(0)->get_data().src;
+            else
+                label = vertex.inedge(0)->get_data().dst;
+        } else {
+            //the multiset is collected in the scratch arena of the update thread, which keeps its buffer between updates
+            std::vector<uint64_t> &labels = gcontext.scratch().get<uint64_t>(0);
+            for (int i = 0; i < vertex.num_inedges(); i++)
+                labels.push_back(vertex.inedge(i)->get_data().src);
+            for (int i = 0; i < vertex.num_outedges(); i++)
+                labels.push_back(vertex.outedge(i)->get_data().dst);
+            labels.push_back(vertex.get_data());
+            label = hash_labels(labels);
+            if (verify != NULL && !verify->check(label, labels))
+                logstream(LOG_WARNING) << "Label " << label << " of vertex " << vertex.id() << " collides with the label of another multiset" << std::endl;
+        }
+        vertex.set_data(label);
+        map_lock.lock();
+        updateOrInsert(label);
+        map_lock.unlock();
+        
+        // broadcast new label to neighbors by writing the value to the edges
+        if (gcontext.iteration > 0) {
+            for (int i = 0; i < vertex.num_inedges(); i++) {
+                graphchi_edge<EdgeDataType> * in_edge = vertex.inedge(i);
+                edge_labels data = in_edge->get_data();
+                data.dst = label;
+                in_edge->set_data(data);
+            }
+            for (int i = 0; i < vertex.num_outedges(); i++) {
+                graphchi_edge<EdgeDataType> * out_edge = vertex.outedge(i);
+                edge_labels data = out_edge->get_data();
+                data.src = label;
+                out_edge->set_data(data);
+            }
+        }
+    }
+    
+    void before_iteration(int iteration, graphchi_context &gcontext) {
+        std::cout << "Before " << iteration << "th iteration:" << std::endl;
+        print_map();
+    }
+    
+    void after_iteration(int iteration, graphchi_context &gcontext) {
+        std::cout << "After " << iteration << "th iteration:" << std::endl;
+        print_map();
+    }
+    
+    void before_exec_interval(vid_t window_st, vid_t window_en, graphchi_context &gcontext) {
+    }
+    
+    void after_exec_interval(vid_t window_st, vid_t window_en, graphchi_context &gcontext) {
+    }
+    
+};
+
+#else
+
 /**
  * GraphChi programs need to subclass GraphChiProgram<vertex-type, edge-type>
  * class. The main logic is usually in the update function.
@@ -197,6 +336,8 @@ struct VertexRelabel : public GraphChiProgram<VertexDataType, EdgeDataType> {
     
 };
 
+#endif
+
 int main(int argc, const char ** argv) {
     /* GraphChi initialization will read the command line
      arguments and the configuration file. */
@@ -213,6 +354,21 @@ int main(int argc, const char ** argv) {
     //TODO: should I use selective scheduling?
     bool scheduler       = false;//not for now
     
+#if INTEGER_LABELS
+    bool verify_labels   = get_option_int("verify_labels", 0); // Whether to check the labels for hash collisions
+    
+    /* Detect the number of shards or preprocess an input to create them */
+    int nshards          = convert_if_notexists<EdgeDataType>(filename,
+                                                               get_option_string("nshards", "auto"));
+    
+    /* Run */
+    label_collisions collisions;
+    VertexRelabel program(verify_labels ? &collisions : NULL);
+    graphchi_engine<VertexDataType, EdgeDataType> engine(filename, nshards, scheduler, m);
+    engine.run(program, niters);
+    if (verify_labels)
+        logstream(LOG_INFO) << "Label collisions: " << collisions.collisions() << std::endl;
+#else
     /* Detect the number of shards or preprocess an input to create them */
     int nshards          = convert_if_notexists<std::string>(filename,
                                                               get_option_string("nshards", "auto"));
@@ -221,6 +377,7 @@ int main(int argc, const char ** argv) {
     VertexRelabel program;
     graphchi_engine<VertexDataType, EdgeDataType> engine(filename, nshards, scheduler, m);
     engine.run(program, niters);
+#endif
     
     /* Report execution metrics */
     metrics_report(m);
@@ -0,0 +1,210 @@
+//
+//  alloc_benchmark.cpp
+//  graphchi_xcode
+//
+//  Counts heap allocations (and bytes) made by the profile and clustering stages of main.cpp
+//  The graphs are relabeled first (not counted); then every stage after it is run the way main.cpp runs it
+//  Usage (same graph options as main): bin/myapps/alloc_benchmark ngraphs 18 file0 server/edgeList1.txt ... file17 dataset1/edgeList8.txt niters 4 filetype edgelist
+//  Every learning graph is also scored as a monitored instance, so the detection stage runs ngraphs times
+//  The same file also builds against the tree before count arrays were passed by reference, with ALLOC_BENCHMARK_BASELINE
+//  defined (the relabel and label map calls of that tree). From the top of this tree, the counts before the change are:
+//    git worktree add /tmp/alloc_baseline $(git log --format=%H --diff-filter=A -- myapps/alloc_benchmark.cpp)~1
+//    cp myapps/alloc_benchmark.cpp /tmp/alloc_baseline/myapps/
+//    make -C /tmp/alloc_baseline CPP="g++ -DALLOC_BENCHMARK_BASELINE" myapps/alloc_benchmark
+//  and /tmp/alloc_baseline/bin/myapps/alloc_benchmark runs with the same options (from myapps/, as this one)
+//
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+#include <new>
+#include <malloc.h>
+#include <atomic>
+#include "kernelmaps.hpp"
+#include "profile.hpp"
+#include "distancematrix.hpp"
+#include "global.h"
+#include "vertex.hpp"
+#include "graphchi_basic_includes.hpp"
+
+using namespace graphchi;
+
+#ifdef ALLOC_BENCHMARK_BASELINE
+//the edge list parser of that tree was in main.cpp
+void parse(type_label &x, const char * s) {
+    char * ss = (char *) s;
+    char delims[] = ":";
+    char * t = strtok(ss, delims);
+    assert(t != NULL);
+    x.new_src = atoi(t);
+    t = strtok(NULL, delims);
+    assert(t != NULL);
+    x.new_dst = atoi(t);
+    t = strtok(NULL, delims);
+    assert(t != NULL);
+    x.edge = atoi(t);
+}
+#endif
+
+static std::atomic<long> allocations(0);
+static std::atomic<long> allocated_bytes(0);
+static std::atomic<long> live_bytes(0);
+static std::atomic<long> peak_live_bytes(0);
+
+//blocks stay plain malloc blocks (parts of GraphChi free what they new), live bytes are tracked with malloc_usable_size
+void * operator new(size_t size) {
+    void * block = malloc(size);
+    if (block == NULL)
+        throw std::bad_alloc();
+    allocations++;
+    allocated_bytes += size;
+    long live = (live_bytes += malloc_usable_size(block));
+    long peak = peak_live_bytes.load();
+    while (live > peak && !peak_live_bytes.compare_exchange_weak(peak, live)) {}
+    return block;
+}
+
+//gcc flags free() in operator delete as a mismatched deallocation; here it is the matching one
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void operator delete(void * ptr) noexcept {
+    if (ptr == NULL)
+        return;
+    live_bytes -= malloc_usable_size(ptr);
+    free(ptr);
+}
+
+void * operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete[](void * ptr) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete(void * ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete[](void * ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+struct stage_counter {
+    long allocations;
+    long bytes;
+    long live;
+
+    void start() {
+        this->allocations = ::allocations.load();
+        this->bytes = allocated_bytes.load();
+        this->live = live_bytes.load();
+        peak_live_bytes = this->live;
+    }
+
+    void report(const char * stage) {
+        std::cout << stage << "\t" << ::allocations.load() - this->allocations << "\t" << allocated_bytes.load() - this->bytes
+                  << "\t" << peak_live_bytes.load() - this->live << std::endl;
+    }
+};
+
+int main(int argc, const char ** argv) {
+    graphchi_init(argc, argv);
+    metrics m("Allocation Benchmark");
+    int num_graphs = get_option_int("ngraphs");
+    int niters = get_option_int("niters", 4);
+    std::vector<std::string> filenames;
+    std::vector<int> nshards;
+    for (int i = 0; i < num_graphs; i++) {
+        std::stringstream name;
+        name << "file" << i;
+        filenames.push_back(get_option_string(name.str().c_str()));
+        nshards.push_back(convert_if_notexists<EdgeDataType>(filenames[i], get_option_string("nshards", "auto")));
+    }
+
+    KernelMaps* km = KernelMaps::get_instance();
+    km->resetMaps();
+    for (int i = 0; i < num_graphs; i++) {
+        km->insert_label_map();
+        graphchi_engine<VertexDataType, EdgeDataType> engine(filenames[i], nshards[i], false, m);
+#ifdef ALLOC_BENCHMARK_BASELINE
+        VertexRelabel program;
+        engine.run(program, niters);
+#else
+        run_relabel(engine, niters);
+#endif
+    }
+
+    std::cout << "stage\tallocations\tbytes\tpeak live bytes" << std::endl;
+    stage_counter counter;
+    profile pf;
+
+    counter.start();
+    {
+#ifdef ALLOC_BENCHMARK_BASELINE
+        //get_label_maps returned a copy, and generate_count_array took a mutable map
+        std::vector<std::map<int, int>> label_maps = km->get_label_maps();
+        for (std::vector<std::map<int, int>>::iterator it = label_maps.begin(); it != label_maps.end(); it++)
+#else
+        const std::vector<std::map<int, int>>& label_maps = km->get_label_maps();
+        for (std::vector<std::map<int, int>>::const_iterator it = label_maps.begin(); it != label_maps.end(); it++)
+#endif
+            pf.add_array(km->generate_count_array(*it));
+    }
+    counter.report("count arrays");
+
+    counter.start();
+    std::vector<double> distance_matrix;
+    {
+        const std::vector<sparse_count_array>& count_arrays = pf.get_count_arrays();
+        DistanceMatrix matrix(0);
+        matrix.append(count_arrays);
+        distance_matrix = matrix.condensed();
+    }
+    counter.report("distance matrix");
+
+    counter.start();
+    int k = 0;
+    {
+        std::pair<std::vector<std::vector<int>>, std::vector<std::vector<double>>> cluster_prior_results = kmeans_prior(num_graphs, distance_matrix);
+        for (size_t i = 0; i < cluster_prior_results.first.size(); i++)
+            if (cluster_prior_results.first[i].size() > 0)
+                k++;
+    }
+    counter.report("kmeans_prior");
+
+    counter.start();
+    std::vector<sparse_count_array> final_centroids;
+    {
+        std::vector<int> seeds;
+        for (int i = 0; i < k; i++)
+            seeds.push_back(i * num_graphs / k);
+        const std::vector<sparse_count_array>& count_arrays = pf.get_count_arrays();
+        std::pair<std::vector<std::vector<int>>, std::vector<std::vector<double>>> cluster_results = kmeans(k, seeds, count_arrays, final_centroids);
+        for (size_t i = 0; i < final_centroids.size(); i++)
+            pf.add_centroid(final_centroids[i]);
+    }
+    counter.report("kmeans");
+
+    counter.start();
+    for (int i = 0; i < num_graphs; i++) {
+        const std::vector<sparse_count_array>& profile_centroids = pf.get_centroids();
+        sparse_count_array monitored_array = pf.get_count_arrays()[i];//main generates a new one per monitored graph
+        for (size_t c = 0; c < profile_centroids.size(); c++)
+            pf.calculate_distance(0, profile_centroids[c], monitored_array);
+        std::vector<sparse_count_array> total_count_arrays = pf.get_count_arrays();
+        total_count_arrays.push_back(monitored_array);
+        std::vector<sparse_count_array> total_centroids = pf.get_centroids();
+        total_centroids.push_back(monitored_array);
+        std::pair<std::vector<std::vector<int>>, std::vector<std::vector<double>>> cluster_monitor_results = kmeans_monitor(total_centroids.size(), total_count_arrays, total_centroids);
+        for (size_t j = 0; j < cluster_monitor_results.first.size(); j++)
+            if (cluster_monitor_results.first[j].size() == 1 && cluster_monitor_results.first[j][0] == (int)pf.get_count_arrays().size())
+                break;
+    }
+    counter.report("detection");
+    return 0;
+}
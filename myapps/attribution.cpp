@@ -0,0 +1,105 @@
+//
+//  attribution.cpp
+//  graphchi_xcode
+//
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <sstream>
+#include "attribution.hpp"
+
+std::vector<label_contribution> distance_contributions(int method, const sparse_count_array& instance, const sparse_count_array& centroid,
+                                                       size_t n, double& total) {
+    assert(instance.dim == centroid.dim);
+    std::vector<label_contribution> contributions;
+    contributions.reserve(instance.nnz() + centroid.nnz());
+    distribution_scale scale_1 = count_distribution(instance, method == 0);
+    distribution_scale scale_2 = count_distribution(centroid, method == 0);
+    total = 0.0;
+    merge_labels(instance.index, centroid.index, [&](int i, int j) {
+        label_contribution c;
+        c.label = i < 0 ? centroid.index[j] : instance.index[i];
+        c.count = i < 0 ? 0 : instance.value[i];
+        c.centroid_count = j < 0 ? 0 : centroid.value[j];
+        if (method == 0) {//same terms as calculate_distance2
+            double p = i < 0 ? scale_1.zero_value : scale_1.probability(c.count);
+            double q = j < 0 ? scale_2.zero_value : scale_2.probability(c.centroid_count);
+            c.term = (p - q) * log(p / q);
+        } else if (method == 1) {
+            double p = i < 0 ? 0.0 : scale_1.probability(c.count);
+            double q = j < 0 ? 0.0 : scale_2.probability(c.centroid_count);
+            c.term = (sqrt(p) - sqrt(q)) * (sqrt(p) - sqrt(q));
+        } else {
+            c.term = (double)(c.count - c.centroid_count) * (c.count - c.centroid_count);
+        }
+        total += c.term;
+        contributions.push_back(c);
+    });
+    long both_zero = instance.dim - (long)contributions.size();
+    if (method == 0 && both_zero > 0) {
+        double p = scale_1.zero_value;
+        double q = scale_2.zero_value;
+        total += both_zero * ((p - q) * log(p / q));
+    }
+
+    n = std::min(n, contributions.size());
+    std::partial_sort(contributions.begin(), contributions.begin() + n, contributions.end(),
+                      [](const label_contribution& a, const label_contribution& b) {
+                          return a.term > b.term || (a.term == b.term && a.label < b.label);
+                      });
+    return contributions;
+}
+
+void label_subtrees::build() {
+    KernelMaps* km = KernelMaps::get_instance();
+    this->kinds.reserve((size_t)std::max(0, km->get_counter()));
+    this->offsets.assign(1, 0);
+    //ids come in order: the labels that are missing from the table get an empty tuple
+    km->for_each_relabel([&](int kind, const int * labels, size_t len, int id) {
+        assert((size_t)id >= this->kinds.size());
+        while (this->kinds.size() < (size_t)id) {
+            this->kinds.push_back(-1);
+            this->offsets.push_back(this->pool.size());
+        }
+        this->kinds.push_back(kind);
+        this->pool.insert(this->pool.end(), labels, labels + len);
+        this->offsets.push_back(this->pool.size());
+    });
+}
+
+std::string label_subtrees::tuple(int label) const {
+    if (label < 0 || (size_t)label >= this->kinds.size() || this->kinds[label] < 0)
+        return "?";
+    return LabelTable::key_string(this->kinds[label], this->pool.data() + this->offsets[label],
+                                  this->offsets[label + 1] - this->offsets[label]);
+}
+
+std::string label_subtrees::subtree(int label) {
+    std::call_once(this->built, [this]() { this->build(); });
+    std::string key = this->tuple(label);
+    if (key == "?" || this->kinds[label] != RELABEL_COMBINED)
+        return key;
+    const int * parts = this->pool.data() + this->offsets[label];
+    std::stringstream out;
+    out << key << " (in " << this->tuple(parts[0]) << "; out " << this->tuple(parts[1]) << ")";
+    return out.str();
+}
+
+void report_attribution(std::ostream& out, int method, const sparse_count_array& instance, const sparse_count_array& centroid, int cluster,
+                        double distance, size_t n) {
+    static label_subtrees subtrees;
+    static const char * metric_names[] = {"KL", "Hellinger", "Euclidean"};
+    double total = 0.0;
+    std::vector<label_contribution> contributions = distance_contributions(method, instance, centroid, n, total);
+    n = std::min(n, contributions.size());
+    std::stringstream report;
+    report << "Attribution to nearest cluster " << cluster << " (" << metric_names[method] << " distance " << distance << "): top "
+        << n << " of " << contributions.size() << " labels of the two" << std::endl;
+    for (size_t i = 0; i < n; i++) {
+        const label_contribution& c = contributions[i];
+        report << "\tlabel " << c.label << "\tcount " << c.count << "\tcentroid " << c.centroid_count << "\tterm " << c.term
+            << "\tshare " << (total > 0.0 ? 100.0 * c.term / total : 0.0) << "%\tsubtree " << subtrees.subtree(c.label) << std::endl;
+    }
+    out << report.str();
+}
@@ -0,0 +1,64 @@
+//
+//  attribution.hpp
+//  graphchi_xcode
+//
+
+#ifndef attribution_hpp
+#define attribution_hpp
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <mutex>
+#include "countarray.hpp"
+#include "profile.hpp"
+#include "kernelmaps.hpp"
+#include "labeltable.hpp"
+
+//Share of one label in the distance between a count array and a centroid
+struct label_contribution {
+    int label;
+    int count;//in the count array
+    int centroid_count;
+    double term;
+};
+
+//Terms of the distance of calculate_distance2 (method 0 symmetric KL, 1 Hellinger, 2 Euclidean) between instance and centroid,
+//one per label either of them has: (p - q) log(p / q), (sqrt(p) - sqrt(q))^2 and (a - b)^2, with the distributions (and the KL
+//back-off) of calculate_distance2. The n largest come first, in decreasing order (a partial sort: the rest are in no order)
+//total is the sum of all terms, the labels neither array has included, so term / total is the share of a label: of the distance
+//for KL, of twice its square for Hellinger and of its square for Euclidean
+std::vector<label_contribution> distance_contributions(int method, const sparse_count_array& instance, const sparse_count_array& centroid,
+                                                       size_t n, double& total);
+
+//Subtree strings of the labels of the relabel table: the tuple a label compresses, as print_relabel_map prints it
+//(LabelTable::key_string). A combined tuple ("in,out") is followed by the tuples of its incoming and outgoing parts
+//The table is indexed by label on first use, so nothing is spent before an instance is flagged. Labels that are added to the
+//relabel table afterwards are not found (the detection stage only looks labels up)
+class label_subtrees {
+public:
+
+    std::string subtree(int label);
+
+private:
+
+    void build();
+
+    std::string tuple(int label) const;
+
+    std::once_flag built;
+
+    std::vector<int> kinds;//per label, -1 if it is not in the table
+
+    std::vector<size_t> offsets;//of the tuple of each label in pool; the tuple of label l ends at offsets[l + 1]
+
+    std::vector<int> pool;
+};
+
+//Attribution report of a flagged instance: the n labels that contribute most to its distance from the centroid of cluster (its
+//nearest one), with their counts, terms, shares and subtree strings
+void report_attribution(std::ostream& out, int method, const sparse_count_array& instance, const sparse_count_array& centroid, int cluster,
+                        double distance, size_t n);
+
+#include "attribution.cpp"
+#endif /* attribution_hpp */
@@ -0,0 +1,59 @@
+//
+//  camflow2shards.cpp
+//  graphchi_xcode
+//
+//  Ingests a camflow audit log (PROV-JSON, one document per line) straight into the shards of a graph: the edges are
+//  converted in memory (see prov_json_converter) and handed to the sharder as they are complete, without writing the
+//  edge list and parsing it again (log -> jsonparser -> edgeList.txt -> convert_if_notexists -> shards)
+//  Usage: bin/myapps/camflow2shards input /tmp/audit.log graph server/graph1 [nshards auto] [threads N]
+//  Then run main with file0 server/graph1 ...: it finds the shards of the graph. Keep the graph name free of a file
+//  (if a file by that name is newer than the shards, main shards that file instead)
+//  input - reads the standard input; threads N (0 for every core) converts a log file in parallel, as provjson2edges
+//
+
+#include <string>
+#include <iostream>
+#include <cassert>
+#include <omp.h>
+#include "global.h"
+#include "provedges.hpp"
+#include "provjson.hpp"
+#include "graphchi_basic_includes.hpp"
+
+using namespace graphchi;
+
+int main(int argc, const char ** argv) {
+    graphchi_init(argc, argv);
+    metrics m("camflow2shards");
+    std::string input = get_option_string("input");
+    std::string graph = get_option_string("graph");
+    std::string nshards_string = get_option_string("nshards", "auto");
+    int nthreads = get_option_int("threads", 1);
+    if (nthreads <= 0)
+        nthreads = omp_get_max_threads();
+
+    if (file_exists(graph))
+        logstream(LOG_WARNING) << graph << " is a file; main will shard it instead of using these shards if it is newer" << std::endl;
+    //shards of an earlier ingestion (possibly into another number of shards) are replaced
+    int nshards = find_shards<EdgeDataType>(graph, nshards_string);
+    if (nshards > 0)
+        delete_shards<EdgeDataType>(graph, nshards);
+
+    sharder<EdgeDataType> sharderobj(graph);
+    sharderobj.start_preprocessing();
+    sharder_edge_sink sink(sharderobj);
+    m.start_time("ingest");
+    prov_json_stats stats = convert_prov_json_log(input, nthreads, sink);
+    m.stop_time("ingest");
+    sharderobj.end_preprocessing();
+    m.start_time("shard");
+    nshards = sharderobj.execute_sharding(nshards_string);
+    m.stop_time("shard");
+
+    if (stats.dropped > 0)
+        logstream(LOG_WARNING) << "Dropped " << stats.dropped << " edges to vertices that are never declared" << std::endl;
+    logstream(LOG_INFO) << "Sharded " << stats.edges << " edges between " << stats.vertices << " vertices of " << input << " into "
+        << nshards << " shards of " << graph << " (skipped " << stats.skipped << " lines that are not JSON)" << std::endl;
+    metrics_report(m);
+    return 0;
+}
@@ -0,0 +1,314 @@
+//
+//  clustering.cpp
+//  graphchi_xcode
+//
+
+#include <cstdlib>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <omp.h>
+#include "clustering.hpp"
+
+kmeans_engine::kmeans_engine(const std::vector<sparse_count_array>& points, int method)
+    : points(points), method(method), bounded(method == 1 || method == 2), is_converged(false), evaluations(0) {}
+
+void kmeans_engine::seed(const std::vector<int>& seeds) {
+    std::vector<sparse_count_array> centroids;
+    centroids.reserve(seeds.size());
+    for (size_t i = 0; i < seeds.size(); i++) {
+        assert(seeds[i] >= 0 && (size_t)seeds[i] < this->points.size());
+        centroids.push_back(this->points[seeds[i]]);
+    }
+    seed(centroids);
+}
+
+void kmeans_engine::seed(const std::vector<sparse_count_array>& centroids) {
+    assert(centroids.size() > 0);
+    this->centroids = centroids;
+    this->assignment.assign(this->points.size(), -1);
+    this->previous.assign(this->points.size(), -1);
+    this->distance.assign(this->points.size(), 0.0);
+    this->tight.assign(this->points.size(), 1);
+    this->lower.assign(this->points.size(), 0.0);
+    this->drift.assign(centroids.size(), 0.0);
+    this->sums.assign(centroids.size(), std::map<int, long>());
+    this->sizes.assign(centroids.size(), 0);
+    this->is_converged = false;
+}
+
+std::vector<int> kmeans_engine::plus_plus_seeds(int k) const {
+    int npoints = (int)this->points.size();
+    assert(k > 0 && npoints > 0);
+    std::vector<int> seeds;
+    seeds.push_back(rand() % npoints);
+    //distance of each point to the closest seed so far
+    std::vector<double> closest(npoints, std::numeric_limits<double>::max());
+    while ((int)seeds.size() < k) {
+        const sparse_count_array& last = this->points[seeds.back()];
+#pragma omp parallel for schedule(dynamic, 16)
+        for (int i = 0; i < npoints; i++) {
+            double d = calculate_distance2(this->method, this->points[i], last);
+            if (d < closest[i])
+                closest[i] = d;
+        }
+        //summed in order, so that the same seeds come out for any number of threads
+        double total = 0.0;
+        for (int i = 0; i < npoints; i++)
+            total += closest[i] * closest[i];
+        int next = rand() % npoints;
+        if (total > 0.0) {
+            double r = rand() / ((double)RAND_MAX + 1.0) * total;
+            for (next = 0; next < npoints - 1; next++) {
+                r -= closest[next] * closest[next];
+                if (r < 0.0)
+                    break;
+            }
+        }
+        seeds.push_back(next);
+    }
+    return seeds;
+}
+
+void kmeans_engine::nearest(int i, int& group, double& min, double& second_min) {
+    int k = (int)this->centroids.size();
+    group = 0;
+    min = calculate_distance2(this->method, this->points[i], this->centroids[0]);
+    second_min = std::numeric_limits<double>::max();
+    for (int c = 1; c < k; c++) {
+        double d = calculate_distance2(this->method, this->points[i], this->centroids[c]);
+        if (d < min) {
+            second_min = min;
+            min = d;
+            group = c;
+        } else if (d < second_min) {
+            second_min = d;
+        }
+    }
+}
+
+bool kmeans_engine::assign() {
+    int npoints = (int)this->points.size();
+    int k = (int)this->centroids.size();
+    this->previous = this->assignment;
+
+    //half the distance of each centroid to the closest other one: a point closer than that to its centroid is closer to it
+    //than to any other centroid
+    std::vector<double> half_gap(k, std::numeric_limits<double>::max());
+    if (this->bounded) {
+        for (int c = 0; c < k; c++) {
+            for (int o = c + 1; o < k; o++) {
+                double d = calculate_distance2(this->method, this->centroids[c], this->centroids[o]) / 2;
+                half_gap[c] = std::min(half_gap[c], d);
+                half_gap[o] = std::min(half_gap[o], d);
+            }
+        }
+        this->evaluations += (long)k * (k - 1) / 2;
+    }
+
+    bool moved = false;
+    long evaluations = 0;
+#pragma omp parallel for schedule(dynamic, 16) reduction(||:moved) reduction(+:evaluations)
+    for (int i = 0; i < npoints; i++) {
+        int current = this->assignment[i];
+        //the bounds are strict, so that a point is only kept where a full comparison (first centroid on a tie) would put it
+        if (this->bounded && current >= 0) {
+            double bound = std::max(half_gap[current], this->lower[i]);
+            if (this->distance[i] < bound)
+                continue;
+            if (!this->tight[i]) {
+                this->distance[i] = calculate_distance2(this->method, this->points[i], this->centroids[current]);
+                this->tight[i] = 1;
+                evaluations++;
+                if (this->distance[i] < bound)
+                    continue;
+            }
+        }
+        int group;
+        double min, second_min;
+        nearest(i, group, min, second_min);
+        evaluations += k;
+        moved = moved || group != current;
+        this->assignment[i] = group;
+        this->distance[i] = min;
+        this->tight[i] = 1;
+        this->lower[i] = second_min;
+    }
+    this->evaluations += evaluations;
+    return moved;
+}
+
+void kmeans_engine::move_bounds() {
+    int k = (int)this->centroids.size();
+    //the largest and second largest drift: every point uses the largest one of the centroids other than its own
+    int farthest = 0;
+    double max_drift = 0.0;
+    double second_drift = 0.0;
+    for (int c = 0; c < k; c++) {
+        if (this->drift[c] > max_drift) {
+            second_drift = max_drift;
+            max_drift = this->drift[c];
+            farthest = c;
+        } else if (this->drift[c] > second_drift) {
+            second_drift = this->drift[c];
+        }
+    }
+    for (size_t i = 0; i < this->points.size(); i++) {
+        int group = this->assignment[i];
+        if (this->drift[group] > 0.0) {
+            this->distance[i] += this->drift[group];
+            this->tight[i] = 0;
+        }
+        this->lower[i] -= group == farthest ? second_drift : max_drift;
+    }
+}
+
+bool kmeans_engine::update() {
+    int k = (int)this->centroids.size();
+    std::vector<bool> dirty(k, false);
+    for (size_t i = 0; i < this->points.size(); i++) {
+        int from = this->previous[i];
+        int to = this->assignment[i];
+        if (from == to)
+            continue;
+        const sparse_count_array& point = this->points[i];
+        if (from >= 0) {
+            std::map<int, long>& sum = this->sums[from];
+            for (size_t j = 0; j < point.index.size(); j++) {
+                std::map<int, long>::iterator itr = sum.find(point.index[j]);
+                assert(itr != sum.end());
+                itr->second -= point.value[j];
+                if (itr->second == 0)
+                    sum.erase(itr);
+            }
+            this->sizes[from]--;
+            dirty[from] = true;
+        }
+        std::map<int, long>& sum = this->sums[to];
+        for (size_t j = 0; j < point.index.size(); j++) {
+            std::map<int, long>::iterator itr = sum.insert(std::pair<int, long>(point.index[j], 0)).first;
+            itr->second += point.value[j];
+            if (itr->second == 0)
+                sum.erase(itr);
+        }
+        this->sizes[to]++;
+        dirty[to] = true;
+    }
+
+    bool changed = false;
+    this->drift.assign(k, 0.0);
+    for (int c = 0; c < k; c++) {
+        if (!dirty[c] || this->sizes[c] == 0)
+            continue;
+        sparse_count_array centroid(this->centroids[c].dim);
+        for (std::map<int, long>::const_iterator itr = this->sums[c].begin(); itr != this->sums[c].end(); itr++) {
+            if (itr->second / this->sizes[c] != 0)
+                centroid.push_back(itr->first, (int)(itr->second / this->sizes[c]));
+        }
+        if (centroid != this->centroids[c]) {
+            if (this->bounded) {
+                this->drift[c] = calculate_distance2(this->method, this->centroids[c], centroid);
+                this->evaluations++;
+            }
+            this->centroids[c] = std::move(centroid);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+int kmeans_engine::run(int max_iterations) {
+    assert(this->centroids.size() > 0);
+    int passes = 0;
+    this->is_converged = false;
+    while (max_iterations <= 0 || passes < max_iterations) {
+        passes++;
+        //every cluster is unchanged when no point moved, so neither is any centroid
+        bool moved = assign();
+        if (!update() || !moved) {
+            this->is_converged = true;
+            break;
+        }
+        if (this->bounded)
+            move_bounds();
+    }
+    //the clusters report the distance of every point to its centroid; when the cap stopped the passes, the centroids
+    //moved after the last assignment
+    int npoints = (int)this->points.size();
+    long evaluations = 0;
+#pragma omp parallel for schedule(dynamic, 16) reduction(+:evaluations)
+    for (int i = 0; i < npoints; i++) {
+        if ((!this->tight[i] || !this->is_converged) && this->assignment[i] >= 0) {
+            this->distance[i] = calculate_distance2(this->method, this->points[i], this->centroids[this->assignment[i]]);
+            this->tight[i] = 1;
+            evaluations++;
+        }
+    }
+    this->evaluations += evaluations;
+    return passes;
+}
+
+cluster_result kmeans_engine::clusters() const {
+    std::vector<std::vector<int>> rtn(this->centroids.size());
+    std::vector<std::vector<double>> rtn_distance(this->centroids.size());
+    for (size_t i = 0; i < this->points.size(); i++) {
+        if (this->assignment[i] < 0)
+            continue;
+        rtn[this->assignment[i]].push_back((int)i);
+        rtn_distance[this->assignment[i]].push_back(this->distance[i]);
+    }
+    return std::make_pair(std::move(rtn), std::move(rtn_distance));
+}
+
+cluster_result kmeans_scalar(const std::vector<double>& points, std::vector<double>& centroids, int max_iterations) {
+    int npoints = (int)points.size();
+    int k = (int)centroids.size();
+    assert(k > 0);
+    std::vector<int> assignment(npoints, 0);
+    std::vector<double> distance(npoints, 0.0);
+    std::vector<double> sums(k);
+    std::vector<long> sizes(k);
+    int passes = 0;
+    bool converge = false;
+    while (!converge && (max_iterations <= 0 || passes < max_iterations)) {
+        passes++;
+#pragma omp parallel for schedule(static)
+        for (int i = 0; i < npoints; i++) {
+            int group = 0;
+            double min = fabs(points[i] - centroids[0]);
+            for (int c = 1; c < k; c++) {
+                double d = fabs(points[i] - centroids[c]);
+                if (d < min) {
+                    min = d;
+                    group = c;
+                }
+            }
+            assignment[i] = group;
+            distance[i] = min;
+        }
+        //summed in order, so that a centroid is the same mean for any number of threads
+        sums.assign(k, 0.0);
+        sizes.assign(k, 0);
+        for (int i = 0; i < npoints; i++) {
+            sums[assignment[i]] += points[i];
+            sizes[assignment[i]]++;
+        }
+        converge = true;
+        for (int c = 0; c < k; c++) {
+            //the centroid of an empty cluster is 0, as the mean of no distance
+            double centroid = sizes[c] == 0 ? 0.0 : sums[c] / sizes[c];
+            if (centroid != centroids[c])
+                converge = false;
+            centroids[c] = centroid;
+        }
+    }
+
+    std::vector<std::vector<int>> rtn(k);
+    std::vector<std::vector<double>> rtn_distance(k);
+    for (int i = 0; i < npoints; i++) {
+        rtn[assignment[i]].push_back(i);
+        rtn_distance[assignment[i]].push_back(distance[i]);
+    }
+    return std::make_pair(std::move(rtn), std::move(rtn_distance));
+}
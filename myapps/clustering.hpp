@@ -0,0 +1,115 @@
+//
+//  clustering.hpp
+//  graphchi_xcode
+//
+
+#ifndef clustering_hpp
+#define clustering_hpp
+
+#include <map>
+#include <vector>
+#include <utility>
+#include "countarray.hpp"
+
+//defined in helper.cpp
+double calculate_distance2(int method, const sparse_count_array& count_array1, const sparse_count_array& count_array2);
+
+//clusters in the format the profile is built from: the indices of the points of each cluster (increasing),
+//and the distance of each of them to the centroid it was assigned to
+typedef std::pair<std::vector<std::vector<int>>, std::vector<std::vector<double>>> cluster_result;
+
+//Lloyd's k-means over count arrays
+//A point is assigned to its closest centroid (the first one on a tie); the points are assigned in parallel.
+//Every cluster keeps the running sum of the counts of its points, which is only updated for the points that moved to
+//or away from it, so a centroid (the truncated entry-wise mean, as mean_count_array computes it) is recomputed only when
+//its cluster changed. A cluster that loses all of its points keeps its centroid
+//For the metrics (hellinger and euclidean distance) the triangle inequality bounds the distances as in Hamerly's k-means:
+//every point keeps an upper bound of the distance to its centroid and a lower bound of the distance to every other one,
+//and the bounds are moved by as much as the centroids moved. A point is only compared to the centroids when its bounds
+//overlap, so once the clusters settle a pass costs about one distance per point. The symmetric kullback-leibler divergence
+//is not a metric, so with it every point is compared to every centroid in every pass
+class kmeans_engine {
+public:
+
+    //the points are not copied and must outlive the engine; method is the metric of calculate_distance2
+    kmeans_engine(const std::vector<sparse_count_array>& points, int method = 0);
+
+    //start from the given points as centroids
+    void seed(const std::vector<int>& seeds);
+
+    //start from the given centroids
+    void seed(const std::vector<sparse_count_array>& centroids);
+
+    //k-means++ seeds for seed(): the first one is a point chosen uniformly, every next one a point chosen with probability
+    //proportional to the square of its distance to the closest seed chosen so far
+    std::vector<int> plus_plus_seeds(int k) const;
+
+    //assign and update until no centroid changes, or for at most max_iterations passes (no cap if it is not positive)
+    //returns the number of passes
+    int run(int max_iterations = 0);
+
+    bool converged() const {
+        return this->is_converged;
+    }
+
+    const std::vector<sparse_count_array>& get_centroids() const {
+        return this->centroids;
+    }
+
+    //the clusters of the last assignment pass, with the distance of every point to the centroid of its cluster
+    cluster_result clusters() const;
+
+    //number of distances between a point and a centroid computed so far
+    long get_evaluations() const {
+        return this->evaluations;
+    }
+
+private:
+
+    //assign every point to its closest centroid; returns false if no point changed cluster
+    bool assign();
+
+    //move the counts of the points that changed cluster between the running sums; returns false if no centroid changed
+    bool update();
+
+    //move the bounds of every point by as much as the centroids moved in the last update
+    void move_bounds();
+
+    //closest and second closest centroid of point i, and their distances
+    void nearest(int i, int& group, double& min, double& second_min);
+
+    const std::vector<sparse_count_array>& points;
+
+    int method;
+
+    std::vector<sparse_count_array> centroids;
+
+    std::vector<int> assignment;//cluster of each point in the last pass, -1 before the first one
+
+    std::vector<int> previous;//cluster of each point before the last pass
+
+    bool bounded;//whether the distance is a metric, so that the bounds hold
+
+    std::vector<double> distance;//distance of each point to its centroid in the last pass (an upper bound of it if it is not tight)
+
+    std::vector<char> tight;//whether distance is exact
+
+    std::vector<double> lower;//lower bound of the distance of each point to every centroid other than its own
+
+    std::vector<double> drift;//distance each centroid moved in the last update
+
+    std::vector<std::map<int, long>> sums;//running sum of the counts of the points of each cluster, zeros are erased
+
+    std::vector<long> sizes;//number of points of each cluster
+
+    bool is_converged;
+
+    long evaluations;
+};
+
+//k-means over scalars (the pair-wise distances clustered by kmeans_prior), from the given centroids which are updated in place
+//The centroids are updated with one sum per cluster rather than from copies of the members; an empty cluster gets centroid 0
+cluster_result kmeans_scalar(const std::vector<double>& points, std::vector<double>& centroids, int max_iterations = 0);
+
+#include "clustering.cpp"
+#endif /* clustering_hpp */
@@ -0,0 +1,67 @@
+//
+//  countarray.cpp
+//  graphchi_xcode
+//
+
+#include <cassert>
+#include <algorithm>
+#include "countarray.hpp"
+
+sparse_count_array sparse_count_array::from_label_map(const std::map<int, int>& map, int dim) {
+    sparse_count_array rtn(dim);
+    for (std::map<int, int>::const_iterator itr = map.begin(); itr != map.end() && itr->first < dim; itr++) {
+        if (itr->first >= 0 && itr->second != 0)
+            rtn.push_back(itr->first, itr->second);
+    }
+    return rtn;
+}
+
+sparse_count_array sparse_count_array::from_dense(const std::vector<int>& dense) {
+    sparse_count_array rtn((int)dense.size());
+    for (size_t i = 0; i < dense.size(); i++) {
+        if (dense[i] != 0)
+            rtn.push_back((int)i, dense[i]);
+    }
+    return rtn;
+}
+
+std::vector<int> sparse_count_array::to_dense() const {
+    std::vector<int> rtn(this->dim, 0);
+    for (size_t i = 0; i < this->index.size(); i++)
+        rtn[this->index[i]] = this->value[i];
+    return rtn;
+}
+
+long sparse_count_array::sum() const {
+    long rtn = 0;
+    for (std::vector<int>::const_iterator itr = this->value.begin(); itr != this->value.end(); itr++)
+        rtn += *itr;
+    return rtn;
+}
+
+sparse_count_array mean_count_array(const std::vector<const sparse_count_array*>& arrays) {
+    assert(arrays.size() > 0);
+    int dim = arrays[0]->dim;
+    //gather all (label, count) entries and add up the ones with the same label
+    std::vector<std::pair<int, long>> entries;
+    for (size_t i = 0; i < arrays.size(); i++) {
+        assert(arrays[i]->dim == dim);
+        for (size_t j = 0; j < arrays[i]->index.size(); j++)
+            entries.push_back(std::pair<int, long>(arrays[i]->index[j], arrays[i]->value[j]));
+    }
+    std::sort(entries.begin(), entries.end());
+    sparse_count_array rtn(dim);
+    long size = (long)arrays.size();
+    size_t i = 0;
+    while (i < entries.size()) {
+        int label = entries[i].first;
+        long sum = 0;
+        while (i < entries.size() && entries[i].first == label) {
+            sum += entries[i].second;
+            i++;
+        }
+        if (sum / size != 0)
+            rtn.push_back(label, (int)(sum / size));
+    }
+    return rtn;
+}
@@ -0,0 +1,58 @@
+//
+//  countarray.hpp
+//  graphchi_xcode
+//
+
+#ifndef countarray_hpp
+#define countarray_hpp
+
+#include <map>
+#include <vector>
+
+//A count array that only stores its non-zero entries, sorted by label
+//dim is the length the dense count array would have (the number of labels in the relabel map when it was generated)
+//Most labels of the vocabulary do not appear in a given graph, so this is much smaller than the dense array
+class sparse_count_array {
+public:
+
+    std::vector<int> index;//labels with a non-zero count, increasing
+
+    std::vector<int> value;//count of each label in index
+
+    int dim;
+
+    sparse_count_array(int dim = 0) : dim(dim) {}
+
+    //labels in the map that are not smaller than dim are dropped, like KernelMaps::generate_count_array does
+    static sparse_count_array from_label_map(const std::map<int, int>& map, int dim);
+
+    static sparse_count_array from_dense(const std::vector<int>& dense);
+
+    std::vector<int> to_dense() const;
+
+    //append an entry; labels must be appended in increasing order
+    void push_back(int label, int count) {
+        this->index.push_back(label);
+        this->value.push_back(count);
+    }
+
+    int nnz() const {
+        return (int)this->index.size();
+    }
+
+    long sum() const;
+
+    bool operator==(const sparse_count_array& other) const {
+        return this->dim == other.dim && this->index == other.index && this->value == other.value;
+    }
+
+    bool operator!=(const sparse_count_array& other) const {
+        return !(*this == other);
+    }
+};
+
+//entry-wise integer mean of the given count arrays (truncated, as the dense k-means centroids are); all arrays must have the same dim
+sparse_count_array mean_count_array(const std::vector<const sparse_count_array*>& arrays);
+
+#include "countarray.cpp"
+#endif /* countarray_hpp */
@@ -0,0 +1,122 @@
+//
+//  distance_benchmark.cpp
+//  graphchi_xcode
+//
+//  Micro-benchmark of the profile distance metrics: the sparse merge-join calculate_distance2 against
+//  prepared (precomputed distribution) arrays, merge-joined and dense in every instruction set the CPU supports
+//  Usage: bin/myapps/distance_benchmark narrays 32 density 10 reps 3
+//  density is the percentage of the vocabulary that is non-zero in each array (about 10 in the sample provenance graphs)
+//  Count arrays are synthetic: labels follow a Zipf-like popularity over each vocabulary size, the way a few
+//  common neighborhoods dominate every provenance graph while most labels of the vocabulary are rare
+//
+
+#include <string>
+#include <iostream>
+#include <vector>
+#include <set>
+#include <cmath>
+#include <cstdlib>
+#include <chrono>
+#include "countarray.hpp"
+#include "profile.hpp"
+#include "distancekernels.hpp"
+#include "graphchi_basic_includes.hpp"
+
+using namespace graphchi;
+
+//a count array with (about) nnz distinct labels out of dim, drawn with probability ~ 1 / (rank + 1)
+sparse_count_array synthetic_count_array(int dim, int nnz) {
+    std::set<int> labels;
+    double harmonic = log((double)dim) + 0.5772;
+    while ((int)labels.size() < std::min(nnz, dim)) {
+        double u = rand() / ((double)RAND_MAX + 1);
+        int label = (int)(exp(u * harmonic) - 1);
+        if (label >= dim || labels.count(label) > 0)
+            label = rand() % dim;
+        labels.insert(label);
+    }
+    sparse_count_array rtn(dim);
+    for (std::set<int>::iterator itr = labels.begin(); itr != labels.end(); itr++)
+        rtn.push_back(*itr, 1 + (int)(dim / (double)(*itr + 1) / 16) + rand() % 4);
+    return rtn;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+//times all pairs of the given prepared arrays, returns ns per pair and sets max_diff to the largest relative difference from reference
+double time_prepared(int method, const std::vector<prepared_count_array>& prepared, kernel_isa isa, int reps,
+                     const std::vector<double>& reference, double& max_diff) {
+    int narrays = prepared.size();
+    std::vector<double> distances(reference.size());
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; r++) {
+        size_t k = 0;
+        for (int i = 0; i < narrays; i++)
+            for (int j = i + 1; j < narrays; j++)
+                distances[k++] = prepared_distance(method, prepared[i], prepared[j], isa);
+    }
+    double elapsed = seconds_since(start);
+    max_diff = 0.0;
+    for (size_t k = 0; k < reference.size(); k++) {
+        double diff = fabs(distances[k] - reference[k]) / (fabs(reference[k]) + 1e-300);
+        if (diff > max_diff)
+            max_diff = diff;
+    }
+    return elapsed * 1e9 / ((double)reference.size() * reps);
+}
+
+int main(int argc, const char ** argv) {
+    graphchi_init(argc, argv);
+    int narrays = get_option_int("narrays", 32);
+    int density = get_option_int("density", 10);
+    int reps = get_option_int("reps", 3);
+    const char * metric_names[] = {"kl", "hellinger", "euclidean"};
+    int vocabularies[] = {700, 5000, 50000};
+
+    std::cout << "best kernels: " << kernel_isa_name(best_kernel_isa()) << std::endl;
+    std::cout << "vocabulary\tmetric\tvariant\tns/pair\tmax rel diff" << std::endl;
+    for (int v = 0; v < 3; v++) {
+        int dim = vocabularies[v];
+        int nnz = std::max(1, dim * density / 100);
+        srand(17);
+        std::vector<sparse_count_array> arrays;
+        for (int i = 0; i < narrays; i++)
+            arrays.push_back(synthetic_count_array(dim, nnz));
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::vector<prepared_count_array> merged;
+        for (int i = 0; i < narrays; i++)
+            merged.push_back(prepared_count_array(arrays[i], 0));
+        std::cout << dim << "\t-\tprepare merge\t" << seconds_since(start) * 1e9 / narrays << " (per array)\t-" << std::endl;
+        start = std::chrono::steady_clock::now();
+        std::vector<prepared_count_array> dense;
+        for (int i = 0; i < narrays; i++)
+            dense.push_back(prepared_count_array(arrays[i], dim));
+        std::cout << dim << "\t-\tprepare dense\t" << seconds_since(start) * 1e9 / narrays << " (per array)\t-" << std::endl;
+
+        for (int method = 0; method < 3; method++) {
+            //reference: the sparse merge-join on the raw count arrays
+            std::vector<double> reference;
+            start = std::chrono::steady_clock::now();
+            for (int r = 0; r < reps; r++) {
+                for (int i = 0; i < narrays; i++)
+                    for (int j = i + 1; j < narrays; j++) {
+                        double distance = calculate_distance2(method, arrays[i], arrays[j]);
+                        if (r == 0)
+                            reference.push_back(distance);
+                    }
+            }
+            std::cout << dim << "\t" << metric_names[method] << "\tsparse\t" << seconds_since(start) * 1e9 / (reference.size() * reps) << "\t0" << std::endl;
+
+            double max_diff;
+            double ns = time_prepared(method, merged, KERNEL_SCALAR, reps, reference, max_diff);
+            std::cout << dim << "\t" << metric_names[method] << "\tprepared merge\t" << ns << "\t" << max_diff << std::endl;
+            for (int isa = KERNEL_SCALAR; isa <= best_kernel_isa(); isa++) {
+                ns = time_prepared(method, dense, (kernel_isa)isa, reps, reference, max_diff);
+                std::cout << dim << "\t" << metric_names[method] << "\tdense " << kernel_isa_name((kernel_isa)isa) << "\t" << ns << "\t" << max_diff << std::endl;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,237 @@
+//
+//  distancekernels.cpp
+//  graphchi_xcode
+//
+
+#include <cassert>
+#include <cmath>
+#include "distancekernels.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DISTANCE_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+prepared_count_array::prepared_count_array(const sparse_count_array& count_array, int dense_fraction) : dim(count_array.dim), index(count_array.index) {
+    distribution_scale with_back_off = count_distribution(count_array, true);
+    distribution_scale without_back_off = count_distribution(count_array, false);
+    this->zero_p = with_back_off.zero_value;
+    this->zero_log_p = this->zero_p > 0 ? log(this->zero_p) : 0.0;
+    for (size_t i = 0; i < this->index.size(); i++) {
+        this->p.push_back(with_back_off.probability(count_array.value[i]));
+        this->log_p.push_back(log(this->p[i]));
+        this->sqrt_p.push_back(sqrt(without_back_off.probability(count_array.value[i])));
+        this->count.push_back(count_array.value[i]);
+    }
+    this->dense = dense_fraction > 0 && (long)this->index.size() * dense_fraction >= this->dim;
+    if (this->dense) {
+        this->dense_p.assign(this->dim, this->zero_p);
+        this->dense_log_p.assign(this->dim, this->zero_log_p);
+        this->dense_sqrt_p.assign(this->dim, 0.0);
+        this->dense_count.assign(this->dim, 0.0);
+        for (size_t i = 0; i < this->index.size(); i++) {
+            int label = this->index[i];
+            this->dense_p[label] = this->p[i];
+            this->dense_log_p[label] = this->log_p[i];
+            this->dense_sqrt_p[label] = this->sqrt_p[i];
+            this->dense_count[label] = this->count[i];
+        }
+    }
+}
+
+//merge-join of the precomputed values, as calculate_distance2 does on the count arrays
+static double prepared_distance_sparse(int method, const prepared_count_array& arr1, const prepared_count_array& arr2) {
+    double distance = 0;
+    if (method == 0) {//symmetric kullback-leibler divergence
+        long both_zero = arr1.dim;
+        merge_labels(arr1.index, arr2.index, [&](int i, int j) {
+            double p = i < 0 ? arr1.zero_p : arr1.p[i];
+            double q = j < 0 ? arr2.zero_p : arr2.p[j];
+            double log_p = i < 0 ? arr1.zero_log_p : arr1.log_p[i];
+            double log_q = j < 0 ? arr2.zero_log_p : arr2.log_p[j];
+            distance += (p - q) * (log_p - log_q);
+            both_zero--;
+        });
+        if (both_zero > 0)
+            distance += both_zero * ((arr1.zero_p - arr2.zero_p) * (arr1.zero_log_p - arr2.zero_log_p));
+    }
+    if (method == 1) {//hellinger distance
+        merge_labels(arr1.index, arr2.index, [&](int i, int j) {
+            double a = i < 0 ? 0.0 : arr1.sqrt_p[i];
+            double b = j < 0 ? 0.0 : arr2.sqrt_p[j];
+            distance += (a - b) * (a - b);
+        });
+        distance = sqrt(distance) / sqrt(2);
+    }
+    if (method == 2) {//euclidian distance
+        merge_labels(arr1.index, arr2.index, [&](int i, int j) {
+            double a = i < 0 ? 0.0 : arr1.count[i];
+            double b = j < 0 ? 0.0 : arr2.count[j];
+            distance += (a - b) * (a - b);
+        });
+        distance = sqrt(distance);
+    }
+    return distance;
+}
+
+//symmetric KL: sum of (p1 - p2) * (log p1 - log p2)
+static double kl_kernel_scalar(const double * p1, const double * l1, const double * p2, const double * l2, size_t n) {
+    double distance = 0.0;
+    for (size_t i = 0; i < n; i++)
+        distance += (p1[i] - p2[i]) * (l1[i] - l2[i]);
+    return distance;
+}
+
+//sum of (a - b)^2
+static double sq_diff_kernel_scalar(const double * a, const double * b, size_t n) {
+    double distance = 0.0;
+    for (size_t i = 0; i < n; i++)
+        distance += (a[i] - b[i]) * (a[i] - b[i]);
+    return distance;
+}
+
+#ifdef DISTANCE_KERNELS_X86
+
+__attribute__((target("avx512f")))
+static double hsum_avx512(__m512d v) {
+    double lanes[8];
+    _mm512_storeu_pd(lanes, v);
+    return ((lanes[0] + lanes[4]) + (lanes[1] + lanes[5])) + ((lanes[2] + lanes[6]) + (lanes[3] + lanes[7]));
+}
+
+__attribute__((target("avx2,fma")))
+static double hsum_avx2(__m256d v) {
+    __m128d lo = _mm256_castpd256_pd128(v);
+    __m128d hi = _mm256_extractf128_pd(v, 1);
+    lo = _mm_add_pd(lo, hi);
+    return _mm_cvtsd_f64(lo) + _mm_cvtsd_f64(_mm_unpackhi_pd(lo, lo));
+}
+
+//two accumulators of four lanes each to hide the fma latency
+__attribute__((target("avx2,fma")))
+static double kl_kernel_avx2(const double * p1, const double * l1, const double * p2, const double * l2, size_t n) {
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256d dp0 = _mm256_sub_pd(_mm256_loadu_pd(p1 + i), _mm256_loadu_pd(p2 + i));
+        __m256d dl0 = _mm256_sub_pd(_mm256_loadu_pd(l1 + i), _mm256_loadu_pd(l2 + i));
+        __m256d dp1 = _mm256_sub_pd(_mm256_loadu_pd(p1 + i + 4), _mm256_loadu_pd(p2 + i + 4));
+        __m256d dl1 = _mm256_sub_pd(_mm256_loadu_pd(l1 + i + 4), _mm256_loadu_pd(l2 + i + 4));
+        acc0 = _mm256_fmadd_pd(dp0, dl0, acc0);
+        acc1 = _mm256_fmadd_pd(dp1, dl1, acc1);
+    }
+    double distance = hsum_avx2(_mm256_add_pd(acc0, acc1));
+    return distance + kl_kernel_scalar(p1 + i, l1 + i, p2 + i, l2 + i, n - i);
+}
+
+__attribute__((target("avx2,fma")))
+static double sq_diff_kernel_avx2(const double * a, const double * b, size_t n) {
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256d d0 = _mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i));
+        __m256d d1 = _mm256_sub_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4));
+        acc0 = _mm256_fmadd_pd(d0, d0, acc0);
+        acc1 = _mm256_fmadd_pd(d1, d1, acc1);
+    }
+    double distance = hsum_avx2(_mm256_add_pd(acc0, acc1));
+    return distance + sq_diff_kernel_scalar(a + i, b + i, n - i);
+}
+
+//the remainder is handled with a masked load instead of a scalar loop
+__attribute__((target("avx512f")))
+static double kl_kernel_avx512(const double * p1, const double * l1, const double * p2, const double * l2, size_t n) {
+    __m512d acc0 = _mm512_setzero_pd();
+    __m512d acc1 = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512d dp0 = _mm512_sub_pd(_mm512_loadu_pd(p1 + i), _mm512_loadu_pd(p2 + i));
+        __m512d dl0 = _mm512_sub_pd(_mm512_loadu_pd(l1 + i), _mm512_loadu_pd(l2 + i));
+        __m512d dp1 = _mm512_sub_pd(_mm512_loadu_pd(p1 + i + 8), _mm512_loadu_pd(p2 + i + 8));
+        __m512d dl1 = _mm512_sub_pd(_mm512_loadu_pd(l1 + i + 8), _mm512_loadu_pd(l2 + i + 8));
+        acc0 = _mm512_fmadd_pd(dp0, dl0, acc0);
+        acc1 = _mm512_fmadd_pd(dp1, dl1, acc1);
+    }
+    for (; i < n; i += 8) {
+        __mmask8 mask = (n - i >= 8) ? (__mmask8)0xFF : (__mmask8)((1u << (n - i)) - 1);
+        __m512d dp = _mm512_sub_pd(_mm512_maskz_loadu_pd(mask, p1 + i), _mm512_maskz_loadu_pd(mask, p2 + i));
+        __m512d dl = _mm512_sub_pd(_mm512_maskz_loadu_pd(mask, l1 + i), _mm512_maskz_loadu_pd(mask, l2 + i));
+        acc0 = _mm512_fmadd_pd(dp, dl, acc0);
+    }
+    return hsum_avx512(_mm512_add_pd(acc0, acc1));
+}
+
+__attribute__((target("avx512f")))
+static double sq_diff_kernel_avx512(const double * a, const double * b, size_t n) {
+    __m512d acc0 = _mm512_setzero_pd();
+    __m512d acc1 = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512d d0 = _mm512_sub_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i));
+        __m512d d1 = _mm512_sub_pd(_mm512_loadu_pd(a + i + 8), _mm512_loadu_pd(b + i + 8));
+        acc0 = _mm512_fmadd_pd(d0, d0, acc0);
+        acc1 = _mm512_fmadd_pd(d1, d1, acc1);
+    }
+    for (; i < n; i += 8) {
+        __mmask8 mask = (n - i >= 8) ? (__mmask8)0xFF : (__mmask8)((1u << (n - i)) - 1);
+        __m512d d = _mm512_sub_pd(_mm512_maskz_loadu_pd(mask, a + i), _mm512_maskz_loadu_pd(mask, b + i));
+        acc0 = _mm512_fmadd_pd(d, d, acc0);
+    }
+    return hsum_avx512(_mm512_add_pd(acc0, acc1));
+}
+
+#endif
+
+kernel_isa best_kernel_isa() {
+#ifdef DISTANCE_KERNELS_X86
+    static kernel_isa best = __builtin_cpu_supports("avx512f") ? KERNEL_AVX512
+        : (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) ? KERNEL_AVX2 : KERNEL_SCALAR;
+    return best;
+#else
+    return KERNEL_SCALAR;
+#endif
+}
+
+const char * kernel_isa_name(kernel_isa isa) {
+    switch (isa) {
+        case KERNEL_AVX512: return "avx512";
+        case KERNEL_AVX2: return "avx2";
+        default: return "scalar";
+    }
+}
+
+double prepared_distance(int method, const prepared_count_array& arr1, const prepared_count_array& arr2) {
+    return prepared_distance(method, arr1, arr2, best_kernel_isa());
+}
+
+double prepared_distance(int method, const prepared_count_array& arr1, const prepared_count_array& arr2, kernel_isa isa) {
+    assert(arr1.dim == arr2.dim);
+    assert(isa <= best_kernel_isa());
+    if (!arr1.dense || !arr2.dense)
+        return prepared_distance_sparse(method, arr1, arr2);
+    size_t n = arr1.dim;
+    double (*kl)(const double *, const double *, const double *, const double *, size_t) = kl_kernel_scalar;
+    double (*sq_diff)(const double *, const double *, size_t) = sq_diff_kernel_scalar;
+#ifdef DISTANCE_KERNELS_X86
+    if (isa == KERNEL_AVX2) {
+        kl = kl_kernel_avx2;
+        sq_diff = sq_diff_kernel_avx2;
+    } else if (isa == KERNEL_AVX512) {
+        kl = kl_kernel_avx512;
+        sq_diff = sq_diff_kernel_avx512;
+    }
+#endif
+    double distance = 0;
+    if (method == 0) {//symmetric kullback-leibler divergence
+        distance = kl(arr1.dense_p.data(), arr1.dense_log_p.data(), arr2.dense_p.data(), arr2.dense_log_p.data(), n);
+    }
+    if (method == 1) {//hellinger distance
+        distance = sqrt(sq_diff(arr1.dense_sqrt_p.data(), arr2.dense_sqrt_p.data(), n)) / sqrt(2);
+    }
+    if (method == 2) {//euclidian distance
+        distance = sqrt(sq_diff(arr1.dense_count.data(), arr2.dense_count.data(), n));
+    }
+    return distance;
+}
@@ -0,0 +1,78 @@
+//
+//  distancekernels.hpp
+//  graphchi_xcode
+//
+
+#ifndef distancekernels_hpp
+#define distancekernels_hpp
+
+#include <vector>
+#include "countarray.hpp"
+#include "profile.hpp"//count_distribution and calculate_distance2 (helper.cpp)
+
+//Instruction sets the distance kernels are compiled for. The best one the CPU supports is picked at runtime
+enum kernel_isa {
+    KERNEL_SCALAR = 0,
+    KERNEL_AVX2 = 1,
+    KERNEL_AVX512 = 2
+};
+
+//A count array with everything the distance metrics need computed once:
+//p: count distribution with back-off (KL), log_p: log of p, sqrt_p: square root of the distribution without back-off (Hellinger)
+//count: the counts themselves (Euclidean)
+//With these, comparing two arrays needs no log or sqrt calls. The values are kept for the non-zero labels (merge-joined like
+//calculate_distance2), and when the array covers enough of the vocabulary also laid out densely, for the vectorized kernels
+class prepared_count_array {
+public:
+
+    //by default, an array with at least dim / DENSE_FRACTION non-zero labels also gets the dense layout
+    static const int DENSE_FRACTION = 16;
+
+    prepared_count_array() : dim(0), zero_p(0.0), zero_log_p(0.0), dense(false) {}
+
+    //the dense layout is built if nnz * dense_fraction >= dim (0: never, dim: always)
+    prepared_count_array(const sparse_count_array& count_array, int dense_fraction = DENSE_FRACTION);
+
+    int dim;
+
+    std::vector<int> index;//non-zero labels, increasing
+
+    std::vector<double> p;
+
+    std::vector<double> log_p;
+
+    std::vector<double> sqrt_p;
+
+    std::vector<double> count;
+
+    //p and log p of every label not in index
+    double zero_p;
+
+    double zero_log_p;
+
+    bool dense;
+
+    //p, log_p, sqrt_p and count over the whole vocabulary; only filled in if dense
+    std::vector<double> dense_p;
+
+    std::vector<double> dense_log_p;
+
+    std::vector<double> dense_sqrt_p;
+
+    std::vector<double> dense_count;
+};
+
+//the best instruction set supported by both the compiler and the CPU
+kernel_isa best_kernel_isa();
+
+const char * kernel_isa_name(kernel_isa isa);
+
+//same metrics as calculate_distance2 (0: symmetric KL, 1: Hellinger, 2: Euclidean) on prepared arrays
+double prepared_distance(int method, const prepared_count_array& arr1, const prepared_count_array& arr2);
+
+//same as above with the given instruction set, which must be supported (for benchmarking and testing the kernels)
+//pairs where either array has no dense layout are merge-joined, which does not depend on the instruction set
+double prepared_distance(int method, const prepared_count_array& arr1, const prepared_count_array& arr2, kernel_isa isa);
+
+#include "distancekernels.cpp"
+#endif /* distancekernels_hpp */
@@ -0,0 +1,77 @@
+//
+//  distancematrix.cpp
+//  graphchi_xcode
+//
+
+#include <cassert>
+#include <algorithm>
+#include <omp.h>
+#include "distancematrix.hpp"
+
+void DistanceMatrix::append(const std::vector<sparse_count_array>& arrays) {
+    if (arrays.empty())
+        return;
+    int new_dim = arrays[0].dim;
+    for (size_t i = 0; i < arrays.size(); i++)
+        assert(arrays[i].dim == new_dim);
+    int first = this->size();
+    if (first > 0 && new_dim != this->dim()) {
+        assert(new_dim > this->dim());//labels are only ever added to the relabel map
+        for (size_t i = 0; i < this->arrays.size(); i++) {
+            this->arrays[i].dim = new_dim;
+            this->prepared[i] = prepared_count_array(this->arrays[i]);
+        }
+        //Hellinger and Euclidean do not depend on the labels an array does not have, but the prepared layout
+        //(dense or not) may change with dim, so those are recomputed as well to match a matrix built from scratch
+        this->distances.clear();
+        first = 0;
+    }
+    for (size_t i = 0; i < arrays.size(); i++) {
+        this->arrays.push_back(arrays[i]);
+        this->prepared.push_back(prepared_count_array(arrays[i]));
+    }
+    compute_columns(first);
+}
+
+void DistanceMatrix::append(const sparse_count_array& array) {
+    append(std::vector<sparse_count_array>(1, array));
+}
+
+double DistanceMatrix::get(int i, int j) const {
+    assert(i != j && i < this->size() && j < this->size());
+    if (i > j)
+        std::swap(i, j);
+    return this->distances[column_offset(j) + i];
+}
+
+std::vector<double> DistanceMatrix::condensed() const {
+    int n = this->size();
+    std::vector<double> rtn;
+    rtn.reserve(n > 1 ? column_offset(n) : 0);
+    for (int i = 0; i < n; i++)
+        for (int j = i + 1; j < n; j++)
+            rtn.push_back(this->distances[column_offset(j) + i]);
+    return rtn;
+}
+
+void DistanceMatrix::compute_columns(int first) {
+    int n = this->size();
+    this->distances.resize(n > 1 ? column_offset(n) : 0);
+    //tiles of block_size x block_size pairs (i, j), i < j, covering the new columns
+    std::vector<std::pair<int, int>> tiles;
+    for (int jb = first; jb < n; jb += this->block_size)
+        for (int ib = 0; ib < std::min(jb + this->block_size, n); ib += this->block_size)
+            tiles.push_back(std::pair<int, int>(ib, jb));
+    int ntiles = (int)tiles.size();
+#pragma omp parallel for schedule(dynamic, 1)
+    for (int t = 0; t < ntiles; t++) {
+        int ib = tiles[t].first;
+        int jb = tiles[t].second;
+        int jend = std::min(jb + this->block_size, n);
+        for (int j = jb; j < jend; j++) {
+            int iend = std::min(ib + this->block_size, j);
+            for (int i = ib; i < iend; i++)
+                this->distances[column_offset(j) + i] = prepared_distance(this->method, this->prepared[i], this->prepared[j]);
+        }
+    }
+}
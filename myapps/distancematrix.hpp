@@ -0,0 +1,71 @@
+//
+//  distancematrix.hpp
+//  graphchi_xcode
+//
+
+#ifndef distancematrix_hpp
+#define distancematrix_hpp
+
+#include <vector>
+#include "countarray.hpp"
+#include "distancekernels.hpp"
+
+//Pairwise distances between count arrays, built in parallel and extended incrementally as instances are appended
+//Each array is prepared (normalized) once when it is appended. The distances of a batch of new arrays to all arrays
+//are computed in square tiles spread over OpenMP threads
+//Internally distances are stored by column: D(i, j) for i < j is at j * (j - 1) / 2 + i, so that appending
+//an instance only appends its distances to the existing ones
+class DistanceMatrix {
+public:
+
+    //method: 0 symmetric KL, 1 Hellinger, 2 Euclidean (as in calculate_distance2)
+    DistanceMatrix(int method = 0, int block_size = 32) : method(method), block_size(block_size) {}
+
+    //append the arrays and compute their distances to all arrays in the matrix
+    //arrays generated after more graphs were relabeled have a larger dim (the vocabulary grew); all arrays are then
+    //extended to the new dim, which changes the KL back-off of every array, so all distances are recomputed
+    void append(const std::vector<sparse_count_array>& arrays);
+
+    void append(const sparse_count_array& array);
+
+    int size() const {
+        return (int)this->arrays.size();
+    }
+
+    int dim() const {
+        return this->arrays.empty() ? 0 : this->arrays[0].dim;
+    }
+
+    double get(int i, int j) const;
+
+    //the upper triangle row by row, as kmeans_prior expects: with 3 arrays A, B and C, [D(A, B), D(A, C), D(B, C)]
+    std::vector<double> condensed() const;
+
+    void clear() {
+        this->arrays.clear();
+        this->prepared.clear();
+        this->distances.clear();
+    }
+
+private:
+
+    static size_t column_offset(int j) {
+        return (size_t)j * (j - 1) / 2;
+    }
+
+    //compute D(i, j) for all i < j and j in [first, size())
+    void compute_columns(int first);
+
+    int method;
+
+    int block_size;
+
+    std::vector<sparse_count_array> arrays;//kept to prepare again if the vocabulary grows
+
+    std::vector<prepared_count_array> prepared;
+
+    std::vector<double> distances;
+};
+
+#include "distancematrix.cpp"
+#endif /* distancematrix_hpp */
@@ -0,0 +1,50 @@
+//
+//  edgelist2bin.cpp
+//  graphchi_xcode
+//
+//  Converts an edge list "src dst src_type:dst_type:edge_type" (the output of the json parser) to the binary edge list
+//  of provedges.hpp, which main shards straight from a mapping of the file
+//  A fourth type field (":timestamp", as streaming.cpp reads it) is accepted but not kept: binary edge lists carry no time
+//  Usage: bin/myapps/edgelist2bin input server/edgeList1.txt output server/edgeList1.bin
+//  Lines that are not edges (comments, blank or malformed lines) are skipped and counted
+//
+
+#include <string>
+#include <iostream>
+#include <cstdio>
+#include <cassert>
+#include "global.h"
+#include "provedges.hpp"
+#include "graphchi_basic_includes.hpp"
+
+using namespace graphchi;
+
+int main(int argc, const char ** argv) {
+    graphchi_init(argc, argv);
+    std::string input = get_option_string("input");
+    std::string output = get_option_string("output", input + ".bin");
+
+    FILE * in = fopen(input.c_str(), "r");
+    if (in == NULL)
+        logstream(LOG_FATAL) << "Could not open " << input << std::endl;
+    assert(in != NULL);
+
+    prov_edges_writer writer(output, camflow_vertex_types, camflow_edge_types);
+    char line[1024];
+    long skipped = 0;
+    while (fgets(line, sizeof(line), in) != NULL) {
+        prov_edge edge;
+        if (parse_prov_edge(line, edge))
+            writer.add(edge);
+        else if (line[0] != '#' && line[0] != '%')
+            skipped++;
+    }
+    fclose(in);
+    uint64_t nedges = writer.size();
+    if (!writer.close())
+        logstream(LOG_FATAL) << "Could not write " << output << std::endl;
+    logstream(LOG_INFO) << "Wrote " << nedges << " edges of " << input << " to " << output << " (skipped " << skipped << " lines)" << std::endl;
+    if (skipped > 0)
+        logstream(LOG_WARNING) << skipped << " lines of " << input << " are not edges" << std::endl;
+    return 0;
+}
@@ -9,6 +9,15 @@
 #ifndef global_h
 #define global_h
 
+#include <map>
+#include <cstring>
+#include <cstdlib>
+#include <cassert>
+#include <cerrno>
+#include <stdint.h>
+#include "logger/logger.hpp"
+#include "countarray.hpp"
+
 /**
  * Type definitions. Remember to create suitable graph shards using the
  * Sharder-program.
@@ -19,20 +28,91 @@ struct type_label {
     int new_src;
     int new_dst;
     int edge;
+#ifdef SUPPORT_DELETIONS
+    int64_t time;//timestamp of the edge, for the window of streaming.cpp (the only binary with SUPPORT_DELETIONS); 0 if it has none
+#endif
 };
 
+//edge type of an edge removed from the graph (the deletions of the dynamic engine mark the value of an edge); no input edge has it
+#define DELETED_EDGE_TYPE -1
+
+#ifdef SUPPORT_DELETIONS
+#include "api/graph_objects.hpp"
+
+inline bool is_deleted_edge_value(const type_label& x) {
+    return x.edge == DELETED_EDGE_TYPE;
+}
+
+inline void remove_edgev(graphchi::graphchi_edge<type_label> * e) {
+    type_label x = e->get_data();
+    x.edge = DELETED_EDGE_TYPE;
+    e->set_data(x);
+}
+#endif
+
+
+//timestamp field of an edge: a non-negative decimal number that fits in 64 bits (jiffies and epoch milliseconds do not fit in an int)
+inline int64_t parse_edge_time(const char * s) {
+    char * end;
+    errno = 0;
+    long long time = strtoll(s, &end, 10);
+    bool valid = end != s && *end == '\0' && errno == 0 && time >= 0;
+    if (!valid)
+        logstream(LOG_FATAL) << "Timestamp " << s << " is not a non-negative 64-bit number" << std::endl;
+    assert(valid);
+    return (int64_t)time;
+}
+
+// Parse the type value in the file to the type_label structure for reading
+// The format is src_type:dst_type:edge_type, optionally followed by :timestamp
+// The timestamp is checked in every binary but only kept with SUPPORT_DELETIONS (streaming.cpp): the edges of the others stay 20 bytes
+void parse(type_label &x, const char * s) {
+    char * ss = (char *) s;
+    char delims[] = ":";
+    char * t;
+    t = strtok(ss, delims);
+    if (t == NULL)
+        logstream(LOG_FATAL) << "Source Type info does not exist" << std::endl;
+    assert(t != NULL);
+    x.new_src = atoi(t);
+    //TODO: We can make sure type value is never 0 so we can check if parse goes wrong here
+    t = strtok(NULL, delims);
+    if (t == NULL)
+        logstream(LOG_FATAL) << "Destination Type info does not exist" << std::endl;
+    assert (t != NULL);
+    x.new_dst = atoi(t);
+    t = strtok(NULL, delims);
+    if (t == NULL)
+        logstream(LOG_FATAL) << "Edge Type info does not exist" << std::endl;
+    assert (t != NULL);
+    x.edge = atoi(t);
+    if (x.edge == DELETED_EDGE_TYPE)
+        logstream(LOG_FATAL) << "Edge type " << DELETED_EDGE_TYPE << " is reserved for deleted edges" << std::endl;
+    assert(x.edge != DELETED_EDGE_TYPE);
+    t = strtok(NULL, delims);
+    int64_t time = t == NULL ? 0 : parse_edge_time(t);
+#ifdef SUPPORT_DELETIONS
+    x.time = time;
+#else
+    (void)time;
+#endif
+    if (t != NULL)
+        t = strtok(NULL, delims);
+    if (t != NULL)
+        logstream(LOG_FATAL) << "Extra info will be ignored" << std::endl;
+    return;
+}
 
 typedef int VertexDataType;
 typedef type_label EdgeDataType;//src_type dst_type edge_type
 
+//histogram and count array of one monitored graph; every detection job has its own
 struct monitor_profile {
-    std::vector<int> count_array;
+    sparse_count_array count_array;
     std::map<int, int> label_map;
 };
 
 typedef monitor_profile monitor_profile;
 
-monitor_profile monitored;
-
 
 #endif /* global_h */
@@ -0,0 +1,97 @@
+//
+//  graphunion.cpp
+//  graphchi_xcode
+//
+
+#include <cstdlib>
+#include <cassert>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include "graphunion.hpp"
+#include "provedges.hpp"
+#include "global.h"
+
+graph_union::graph_union(const std::vector<std::string>& files, const std::string& union_file) : union_file(union_file) {
+    std::string edges;
+    vid_t offset = 0;
+    for (size_t g = 0; g < files.size(); g++) {
+        this->offsets.push_back(offset);
+        if (is_prov_edges_file(files[g])) {
+            //the union is an edge list as text, so that its shards are built as for any other graph
+            prov_edges_file binary;
+            bool opened = binary.open(files[g]);
+            if (!opened)
+                logstream(LOG_FATAL) << "Could not read binary edge list " << files[g] << std::endl;
+            assert(opened);
+            vid_t max_vertex = 0;
+            const prov_edge * records = binary.edges();
+            for (uint64_t i = 0; i < binary.size(); i++) {
+                std::stringstream shifted;
+                shifted << records[i].src + offset << "\t" << records[i].dst + offset << "\t" << records[i].src_type << ":"
+                    << records[i].dst_type << ":" << records[i].edge_type << "\n";
+                edges += shifted.str();
+                max_vertex = std::max(max_vertex, (vid_t)std::max(records[i].src, records[i].dst));
+            }
+            if (binary.size() > 0)
+                offset += max_vertex + 1;
+            continue;
+        }
+        std::ifstream in(files[g].c_str());
+        if (!in.is_open())
+            logstream(LOG_FATAL) << "Could not open " << files[g] << std::endl;
+        assert(in.is_open());
+        vid_t max_vertex = 0;
+        bool any = false;
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.empty() || line[0] == '#' || line[0] == '%')
+                continue;
+            //"src dst value": the ids are shifted, the rest of the line is kept as it is
+            const char * s = line.c_str();
+            char * end;
+            unsigned long src = strtoul(s, &end, 10);
+            bool parsed = end != s;
+            s = end;
+            unsigned long dst = strtoul(s, &end, 10);
+            parsed = parsed && end != s;
+            if (!parsed) {
+                logstream(LOG_ERROR) << "Skipped malformed edge in " << files[g] << ": " << line << std::endl;
+                continue;
+            }
+            std::stringstream shifted;
+            shifted << src + offset << "\t" << dst + offset << end << "\n";
+            edges += shifted.str();
+            max_vertex = std::max(max_vertex, (vid_t)std::max(src, dst));
+            any = true;
+        }
+        if (any)
+            offset += max_vertex + 1;
+    }
+    this->offsets.push_back(offset);
+
+    std::ifstream existing(union_file.c_str(), std::ios::binary);
+    if (existing.is_open()) {
+        std::stringstream contents;
+        contents << existing.rdbuf();
+        if (contents.str() == edges) {
+            logstream(LOG_INFO) << union_file << " already holds the union of " << files.size() << " graphs" << std::endl;
+            return;
+        }
+        //the shards are of another union; the modification time check of convert_if_notexists only has a resolution of seconds
+        int nshards = find_shards<EdgeDataType>(union_file, get_option_string("nshards", "auto"));
+        if (nshards > 0)
+            delete_shards<EdgeDataType>(union_file, nshards);
+    }
+    std::ofstream out(union_file.c_str(), std::ios::binary | std::ios::trunc);
+    out << edges;
+    if (!out.good())
+        logstream(LOG_FATAL) << "Could not write " << union_file << std::endl;
+    assert(out.good());
+    logstream(LOG_INFO) << "Wrote the union of " << files.size() << " graphs (" << offset << " vertices) to " << union_file << std::endl;
+}
+
+int graph_union::graph_of(vid_t vertex) const {
+    assert(vertex < this->offsets.back());
+    return (int)(std::upper_bound(this->offsets.begin(), this->offsets.end(), vertex) - this->offsets.begin()) - 1;
+}
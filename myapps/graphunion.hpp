@@ -0,0 +1,49 @@
+//
+//  graphunion.hpp
+//  graphchi_xcode
+//
+
+#ifndef graphunion_hpp
+#define graphunion_hpp
+
+#include <string>
+#include <vector>
+#include "graphchi_basic_includes.hpp"
+
+using namespace graphchi;
+
+//Many small graphs packed into one edge list as a disjoint union, so that they are all relabeled in a single engine run
+//Graph g keeps its vertex ids shifted by offset(g): the vertex ids of graph g are [offset(g), offset(g + 1))
+//Edge values are copied as they are, so the union is an edge list of the same format as the graphs
+class graph_union {
+public:
+
+    //write the union of the edge lists in files to union_file. If union_file already holds that union it is left as it is,
+    //so that its shards can be reused; otherwise its old shards are deleted
+    graph_union(const std::vector<std::string>& files, const std::string& union_file);
+
+    const std::string& filename() const {
+        return this->union_file;
+    }
+
+    //number of graphs in the union
+    int size() const {
+        return (int)this->offsets.size() - 1;
+    }
+
+    vid_t offset(int graph) const {
+        return this->offsets[graph];
+    }
+
+    //the graph a vertex of the union belongs to
+    int graph_of(vid_t vertex) const;
+
+private:
+
+    std::string union_file;
+
+    std::vector<vid_t> offsets;//offsets[g] is the first vertex id of graph g, the last one is the number of vertices of the union
+};
+
+#include "graphunion.cpp"
+#endif /* graphunion_hpp */
@@ -11,21 +11,25 @@
 #include <cassert>
 #include <cmath>
 #include <vector>
+#include <utility>
+#include "logger/logger.hpp"
+#include "countarray.hpp"
+#include "clustering.hpp"
 
 //back-off probability can be optionally included in the count distribution
-std::vector<double> count_distribution(std::vector<int> count_array, bool back_off) {
+std::vector<double> count_distribution(const std::vector<int>& count_array, bool back_off) {
     std::vector<double> count_distr;
     int sum = 0;
     int zero_count = 0;
 
-    for (std::vector<int>::iterator itr = count_array.begin(); itr != count_array.end(); itr++) {
+    for (std::vector<int>::const_iterator itr = count_array.begin(); itr != count_array.end(); itr++) {
         if (*itr != 0)
             sum += *itr;
         else zero_count++;
     }
     bool min_exist = false;
     double min = 0.0;
-    for (std::vector<int>::iterator itr = count_array.begin(); itr != count_array.end(); itr++) {
+    for (std::vector<int>::const_iterator itr = count_array.begin(); itr != count_array.end(); itr++) {
         double val = *itr / (double)sum;
         count_distr.push_back(val);
         if (val > 0) {
@@ -51,9 +55,9 @@ std::vector<double> count_distribution(std::vector<int> count_array, bool back_o
     return count_distr;
 }
 
-double mean(std::vector<double> vec) {
+double mean(const std::vector<double>& vec) {
     double sum = 0.0;
-    for (std::vector<double>::iterator itr = vec.begin(); itr != vec.end(); itr++) {
+    for (std::vector<double>::const_iterator itr = vec.begin(); itr != vec.end(); itr++) {
         sum += *itr;
     }
     if (vec.size() == 0)
@@ -61,7 +65,7 @@ double mean(std::vector<double> vec) {
     else return sum / vec.size();
 }
 
-double calculate_distance2(int method, std::vector<int> count_array1, std::vector<int> count_array2) {
+double calculate_distance2(int method, const std::vector<int>& count_array1, const std::vector<int>& count_array2) {
     double distance = 0;
     if (method == 0) {//symmetric kullback-leibler divergence
         std::vector<double> count_distribution_1 = count_distribution(count_array1, true);
@@ -92,8 +96,8 @@ double calculate_distance2(int method, std::vector<int> count_array1, std::vecto
     }
     if (method == 2) {//euclidian distance
         assert(count_array1.size() == count_array2.size());
-        std::vector<int>::iterator itr_1 = count_array1.begin();
-        std::vector<int>::iterator itr_2 = count_array2.begin();
+        std::vector<int>::const_iterator itr_1 = count_array1.begin();
+        std::vector<int>::const_iterator itr_2 = count_array2.begin();
         while (itr_1 != count_array1.end()) {
             distance += (*itr_1 - *itr_2) * (*itr_1 - *itr_2);
             itr_1++;
@@ -104,310 +108,136 @@ double calculate_distance2(int method, std::vector<int> count_array1, std::vecto
     return distance;
 }
 
-//k-mean clustering
-//cluster indices
-//k: number of cluster
-
-std::pair<std::vector<std::vector<int>>, std::vector<std::vector<double>>> kmeans_prior(int k, std::vector<double> distance_matrix) {
-    int matrix_size = distance_matrix.size();
-    double cluster[k];
-    double newCluster[k];
-    double group[k][matrix_size];
-    std::vector<double> newGroup[k];
-    std::vector<std::vector<int>> rtn;
-    std::vector<std::vector<double>> rtn_distance;
-    bool converge = true;
-
-    for (int i = 0; i < k; i++) {
-        std::vector<int> vec;
-        std::vector<double> dis;
-        rtn.push_back(vec);
-        rtn_distance.push_back(dis);
+//count distribution of a sparse count array, without materializing it:
+//the probability of a label the array has is probability(count), and every other label has zero_value
+struct distribution_scale {
+    double sum;
+    double deduct;//taken from every label the array has, to give the back-off probability to the others
+    double zero_value;
 
-        cluster[i] = distance_matrix[rand() % matrix_size];
-        newCluster[i] = 0.0;
+    double probability(int count) const {
+        return count / this->sum - this->deduct;
     }
-    do {
-        converge = true;
-        for (int i = 0; i < k; i++) {
-            int j = 0;
-            for (std::vector<double>::iterator itr = distance_matrix.begin(); itr != distance_matrix.end(); itr++) {
-                group[i][j] = abs(*itr - cluster[i]);
-                j++;
-            }
-        }
-
-        for (int i = 0; i < matrix_size; i++) {
-            int groupNum = 0;
-            double min = group[0][i];
-            for (int p = 1; p < k; p++) {
-                if (group[p][i] < min) {
-                    min = group[p][i];
-                    groupNum = p;
-                }
-            }
-            rtn[groupNum].push_back(i);
-            rtn_distance[groupNum].push_back(min);
-            newGroup[groupNum].push_back(distance_matrix[i]);
-        }
-
-        for (int q = 0; q < k; q++) {
-            newCluster[q] = mean(newGroup[q]);
-        }
-
-        for (int t = 0; t < k; t++) {
-            if (newCluster[t] != cluster[t])
-                converge = false;
-        }
-
-//        std::cout << "rtn value: " << std::endl;
-//        for (std::vector<std::vector<int>>::iterator itr = rtn.begin(); itr != rtn.end(); itr++) {
-//            std::cout << "Cluster: ";
-//            for (std::vector<int>::iterator itr2 = itr->begin(); itr2 != itr->end(); itr2++) {
-//                std::cout << *itr2 << " ";
-//            }
-//            std::cout << std::endl;
-//        }
-//        std:: cout << std::endl;
-
-        if (!converge) {
-            for (int d = 0; d < k; d++) {
-                cluster[d] = newCluster[d];
-                rtn[d].clear();
-                rtn_distance[d].clear();
-                newGroup[d].clear();
-            }
-        }
-
-//        std::cout << "newCluster: ";
-//        for (int i = 0; i < k; i++) {
-//            std::cout << newCluster[i] << " ";
-//        }
-//        std:: cout << std::endl;
-
-    } while (!converge);
-
-    return std::pair<std::vector<std::vector<int>>, std::vector<std::vector<double>>>(rtn, rtn_distance);
+};
+
+//same distribution (and back-off) as the dense count_distribution above
+distribution_scale count_distribution(const sparse_count_array& count_array, bool back_off) {
+    distribution_scale scale;
+    long sum = count_array.sum();
+    //an empty array has no distribution (0 / 0 would make every distance from it NaN)
+    if (sum <= 0)
+        logstream(LOG_FATAL) << "Count distribution of an empty count array (dim " << count_array.dim << ")" << std::endl;
+    assert(sum > 0);
+    int zero_count = count_array.dim - count_array.nnz();
+    scale.sum = (double)sum;
+    scale.deduct = 0.0;
+    scale.zero_value = 0.0;
+
+    //division by sum is monotonic, so this is the smallest non-zero probability
+    int min_count = 0;
+    for (std::vector<int>::const_iterator itr = count_array.value.begin(); itr != count_array.value.end(); itr++) {
+        if (*itr > 0 && (min_count == 0 || *itr < min_count))
+            min_count = *itr;
+    }
+    double min = min_count / scale.sum;
+    assert(min > 0.0);
+    if (back_off) {
+        scale.deduct = (min / 2) / count_array.nnz();
+        if (zero_count > 0)
+            scale.zero_value = (min / 2) / zero_count;
+    }
+    return scale;
 }
 
-std::pair<std::vector<std::vector<int>>, std::vector<std::vector<double>>> kmeans(int k, std::vector<int>seeds, std::vector<std::vector<int>> count_array, std::vector<std::vector<int>>& centroids) {
-    int nvec = count_array.size();
-    int array_size = count_array[0].size();
-
-    std::vector<int> cluster[k];
-    std::vector<int> newCluster[k];
-    double group[k][nvec];
-
-    std::vector<std::vector<int>> newGroup[k];
-    std::vector<std::vector<int>> rtn;  // Final variable to return
-    std::vector<std::vector<double>> rtn_distance;
-
-
-    bool converge = true;
-
-    //Initialize rtn
-
-    for (int i = 0; i < k; i++) {
-        std::vector<int> vec;
-        std::vector<double> dis;
-        rtn.push_back(vec);
-        rtn_distance.push_back(dis);
-
-        std::vector<int> temp (array_size,0);
-        for (int ii = 0; ii < array_size; ii++) {
-            cluster[i].push_back(count_array[seeds[i]][ii]);
-            newCluster[i].push_back(count_array[seeds[i]][ii]);
+//walks the union of the labels of two sorted index vectors in increasing order
+//f(i, j) gets the position of the label in each vector, or -1 if that vector does not have the label
+template <typename F>
+void merge_labels(const std::vector<int>& index1, const std::vector<int>& index2, F f) {
+    size_t i = 0, j = 0;
+    while (i < index1.size() || j < index2.size()) {
+        if (j == index2.size() || (i < index1.size() && index1[i] < index2[j])) {
+            f((int)i, -1);
+            i++;
+        } else if (i == index1.size() || index2[j] < index1[i]) {
+            f(-1, (int)j);
+            j++;
+        } else {
+            f((int)i, (int)j);
+            i++;
+            j++;
         }
     }
+}
 
-    // Calculate distance to each cluster
-    do {
-        converge = true;
-        for (int i = 0; i < k; i++) {
-            int j = 0;
-            for (std::vector<std::vector<int>>::iterator itr = count_array.begin(); itr != count_array.end(); itr++) {
-                group[i][j] = calculate_distance2(0, *itr, cluster[i]);  // distance of j-th entry to i-th cluster
-                j++;
-            }
-        }
-
-        for (int i = 0; i < nvec; i++) {
-            int groupNum = 0;
-            double min = group[0][i];
-            for (int p = 1; p < k; p++) {
-                if (group[p][i] < min) {
-                    min = group[p][i];
-                    groupNum = p;
-                }
-            }
-            rtn[groupNum].push_back(i);
-            rtn_distance[groupNum].push_back(min);
-            newGroup[groupNum].push_back(count_array[i]);
-        }
-
-        for (int q = 0; q < k; q++) {
-            if (newGroup[q].size() != 0) {
-              std::vector<int> sum(array_size,0);
-              for (std::vector<std::vector<int>>::iterator it = newGroup[q].begin(); it != newGroup[q].end(); it++) {
-                for(int f = 0; f < array_size; f++) {
-                  sum[f] += (*it)[f];
-                }
-              }
-              for(int g = 0; g < array_size; g++) {
-                sum[g] /= newGroup[q].size();
-              }
-              for (int d = 0; d < array_size; d++) {
-                newCluster[q][d] = sum[d];// calculate mean of distribution for a cluster
-              }
-            }
-        }
-
-        for (int t = 0; t < k; t++) {
-          for (int r = 0; r < array_size; r++) {
-            if (newCluster[t][r] != cluster[t][r])
-                converge = false;
-          }
-        }
-
-        //        std::cout << "rtn value: " << std::endl;
-        //        for (std::vector<std::vector<int>>::iterator itr = rtn.begin(); itr != rtn.end(); itr++) {
-        //            std::cout << "Cluster: ";
-        //            for (std::vector<int>::iterator itr2 = itr->begin(); itr2 != itr->end(); itr2++) {
-        //                std::cout << *itr2 << " ";
-        //            }
-        //            std::cout << std::endl;
-        //        }
-        //        std:: cout << std::endl;
-
-        if (!converge) {
-            for (int d = 0; d < k; d++) {
-                cluster[d] = newCluster[d];
-                rtn[d].clear();
-                rtn_distance[d].clear();
-                newGroup[d].clear();
-            }
-        } else {
-            for (int t = 0; t < k; t++) {
-                centroids.push_back(newCluster[t]);
-            }
+//same metrics as the dense calculate_distance2, in time linear in the number of non-zero labels of the two arrays
+//and without allocating
+double calculate_distance2(int method, const sparse_count_array& count_array1, const sparse_count_array& count_array2) {
+    assert(count_array1.dim == count_array2.dim);
+    double distance = 0;
+    if (method == 0) {//symmetric kullback-leibler divergence
+        distribution_scale scale_1 = count_distribution(count_array1, true);
+        distribution_scale scale_2 = count_distribution(count_array2, true);
+        long both_zero = count_array1.dim;
+        merge_labels(count_array1.index, count_array2.index, [&](int i, int j) {
+            double p = i < 0 ? scale_1.zero_value : scale_1.probability(count_array1.value[i]);
+            double q = j < 0 ? scale_2.zero_value : scale_2.probability(count_array2.value[j]);
+            distance += (p - q) * log(p / q);
+            both_zero--;
+        });
+        //every label neither array has contributes the same amount
+        if (both_zero > 0) {
+            double p = scale_1.zero_value;
+            double q = scale_2.zero_value;
+            distance += both_zero * ((p - q) * log(p / q));
         }
+    }
+    if (method == 1) {//hellinger distance
+        distribution_scale scale_1 = count_distribution(count_array1, false);
+        distribution_scale scale_2 = count_distribution(count_array2, false);
+        merge_labels(count_array1.index, count_array2.index, [&](int i, int j) {
+            double p = i < 0 ? 0.0 : scale_1.probability(count_array1.value[i]);
+            double q = j < 0 ? 0.0 : scale_2.probability(count_array2.value[j]);
+            distance += (sqrt(p) - sqrt(q)) * (sqrt(p) - sqrt(q));
+        });
+        distance = sqrt(distance) / sqrt(2);
+    }
+    if (method == 2) {//euclidian distance
+        merge_labels(count_array1.index, count_array2.index, [&](int i, int j) {
+            int a = i < 0 ? 0 : count_array1.value[i];
+            int b = j < 0 ? 0 : count_array2.value[j];
+            distance += (a - b) * (a - b);
+        });
+        distance = sqrt(distance);
+    }
+    return distance;
+}
 
-        //        std::cout << "newCluster: ";
-        //        for (int i = 0; i < k; i++) {
-        //            std::cout << newCluster[i] << " ";
-        //        }
-        //        std:: cout << std::endl;
+//k-mean clustering
+//cluster indices
+//k: number of cluster
+//max_iterations: number of passes after which the clusters are returned even if they have not converged (no cap if it is not positive)
+//method: metric of calculate_distance2 the count arrays are clustered with
 
-    } while (!converge);
-    
+std::pair<std::vector<std::vector<int>>, std::vector<std::vector<double>>> kmeans_prior(int k, const std::vector<double>& distance_matrix, int max_iterations = 0) {
+    int matrix_size = distance_matrix.size();
+    std::vector<double> cluster;
+    for (int i = 0; i < k; i++)
+        cluster.push_back(distance_matrix[rand() % matrix_size]);
+    return kmeans_scalar(distance_matrix, cluster, max_iterations);
+}
 
-    return std::pair<std::vector<std::vector<int>>, std::vector<std::vector<double>>>(rtn, rtn_distance);
+std::pair<std::vector<std::vector<int>>, std::vector<std::vector<double>>> kmeans(int k, const std::vector<int>& seeds, const std::vector<sparse_count_array>& count_array, std::vector<sparse_count_array>& centroids, int max_iterations = 0, int method = 0) {
+    assert((int)seeds.size() >= k);
+    kmeans_engine engine(count_array, method);
+    engine.seed(std::vector<int>(seeds.begin(), seeds.begin() + k));
+    engine.run(max_iterations);
+    centroids.insert(centroids.end(), engine.get_centroids().begin(), engine.get_centroids().end());
+    return engine.clusters();
 }
 
-std::pair<std::vector<std::vector<int>>, std::vector<std::vector<double>>> kmeans_monitor(int k, std::vector<std::vector<int>> count_array, std::vector<std::vector<int>> centroids) {
-    int nvec = count_array.size();
-    int array_size = count_array[0].size();
-    
-    std::vector<int> cluster[k];
-    std::vector<int> newCluster[k];
-    double group[k][nvec];
-    
-    std::vector<std::vector<int>> newGroup[k];
-    std::vector<std::vector<int>> rtn;  // Final variable to return
-    std::vector<std::vector<double>> rtn_distance;
-    
-    
-    bool converge = true;
-    
-    //Initialize rtn
-    
-    for (int i = 0; i < k; i++) {
-        std::vector<int> vec;
-        std::vector<double> dis;
-        rtn.push_back(vec);
-        rtn_distance.push_back(dis);
-        
-        for (int ii = 0; ii < array_size; ii++) {
-            cluster[i].push_back(centroids[i][ii]);
-            newCluster[i].push_back(centroids[i][ii]);
-        }
-    }
-    
-    // Calculate distance to each cluster
-    do {
-        converge = true;
-        for (int i = 0; i < k; i++) {
-            int j = 0;
-            for (std::vector<std::vector<int>>::iterator itr = count_array.begin(); itr != count_array.end(); itr++) {
-                group[i][j] = calculate_distance2(0, *itr, cluster[i]);  // distance of j-th entry to i-th cluster
-                j++;
-            }
-        }
-        
-        for (int i = 0; i < nvec; i++) {
-            int groupNum = 0;
-            double min = group[0][i];
-            for (int p = 1; p < k; p++) {
-                if (group[p][i] < min) {
-                    min = group[p][i];
-                    groupNum = p;
-                }
-            }
-            rtn[groupNum].push_back(i);
-            rtn_distance[groupNum].push_back(min);
-            newGroup[groupNum].push_back(count_array[i]);
-        }
-        
-        for (int q = 0; q < k; q++) {
-            if (newGroup[q].size() != 0) {
-                std::vector<int> sum(array_size,0);
-                for (std::vector<std::vector<int>>::iterator it = newGroup[q].begin(); it != newGroup[q].end(); it++) {
-                    for(int f = 0; f < array_size; f++) {
-                        sum[f] += (*it)[f];
-                    }
-                }
-                for(int g = 0; g < array_size; g++) {
-                    sum[g] /= newGroup[q].size();
-                }
-                for (int d = 0; d < array_size; d++) {
-                    newCluster[q][d] = sum[d];// calculate mean of distribution for a cluster
-                }
-            }
-        }
-        
-        for (int t = 0; t < k; t++) {
-            for (int r = 0; r < array_size; r++) {
-                if (newCluster[t][r] != cluster[t][r])
-                    converge = false;
-            }
-        }
-        
-        //        std::cout << "rtn value: " << std::endl;
-        //        for (std::vector<std::vector<int>>::iterator itr = rtn.begin(); itr != rtn.end(); itr++) {
-        //            std::cout << "Cluster: ";
-        //            for (std::vector<int>::iterator itr2 = itr->begin(); itr2 != itr->end(); itr2++) {
-        //                std::cout << *itr2 << " ";
-        //            }
-        //            std::cout << std::endl;
-        //        }
-        //        std:: cout << std::endl;
-        
-        if (!converge) {
-            for (int d = 0; d < k; d++) {
-                cluster[d] = newCluster[d];
-                rtn[d].clear();
-                rtn_distance[d].clear();
-                newGroup[d].clear();
-            }
-        }
-        //        std::cout << "newCluster: ";
-        //        for (int i = 0; i < k; i++) {
-        //            std::cout << newCluster[i] << " ";
-        //        }
-        //        std:: cout << std::endl;
-        
-    } while (!converge);
-    
-    
-    return std::pair<std::vector<std::vector<int>>, std::vector<std::vector<double>>>(rtn, rtn_distance);
+std::pair<std::vector<std::vector<int>>, std::vector<std::vector<double>>> kmeans_monitor(int k, const std::vector<sparse_count_array>& count_array, const std::vector<sparse_count_array>& centroids, int max_iterations = 0, int method = 0) {
+    kmeans_engine engine(count_array, method);
+    engine.seed(std::vector<sparse_count_array>(centroids.begin(), centroids.begin() + k));
+    engine.run(max_iterations);
+    return engine.clusters();
 }
@@ -0,0 +1,257 @@
+//
+//  incrementalrelabel.cpp
+//  graphchi_xcode
+//
+
+#include <string>
+#include <sstream>
+#include <algorithm>
+#include <cassert>
+#include "incrementalrelabel.hpp"
+
+void EdgeBurstQueue::push(std::vector<streamed_edge>&& burst) {
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->bursts.push_back(std::move(burst));
+    this->arrived.notify_one();
+}
+
+void EdgeBurstQueue::close() {
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->closed = true;
+    this->arrived.notify_one();
+}
+
+bool EdgeBurstQueue::pop(std::vector<streamed_edge>& burst) {
+    std::unique_lock<std::mutex> guard(this->lock);
+    while (this->bursts.empty() && !this->closed)
+        this->arrived.wait(guard);
+    if (this->bursts.empty())
+        return false;
+    burst = std::move(this->bursts.front());
+    this->bursts.pop_front();
+    return true;
+}
+
+void read_edge_bursts(std::istream& in, size_t burst_size, EdgeBurstQueue& bursts) {
+    std::vector<streamed_edge> burst;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty()) {
+            if (!burst.empty())
+                bursts.push(std::move(burst));
+            burst.clear();
+            continue;
+        }
+        if (line[0] == '#' || line[0] == '%')
+            continue;
+        std::istringstream fields(line);
+        long src, dst;
+        std::string types;
+        if (!(fields >> src >> dst >> types)) {
+            logstream(LOG_ERROR) << "Skipped malformed edge: " << line << std::endl;
+            continue;
+        }
+        streamed_edge edge;
+        edge.src = (vid_t)src;
+        edge.dst = (vid_t)dst;
+        parse(edge.data, types.c_str());
+        burst.push_back(edge);
+        if (burst.size() >= burst_size) {
+            bursts.push(std::move(burst));
+            burst.clear();
+        }
+    }
+    if (!burst.empty())
+        bursts.push(std::move(burst));
+    bursts.close();
+}
+
+IncrementalVertexRelabel::IncrementalVertexRelabel(engine_type& engine, EdgeBurstQueue& bursts, int niters, std::map<int, int>& label_map, int64_t window)
+    : engine(engine), bursts(bursts), label_map(label_map), nrounds((niters + 1) / 2), next_unknown_label(km->get_counter() + 1),
+      window(window), latest(-1) {
+    assert(this->nrounds >= 1);
+    assert(this->window >= 0);
+    relabel_selection selection = {this};
+    with_relabel_keys(this->km->get_relabel_variant(), selection);
+}
+
+int IncrementalVertexRelabel::lookup_relabel(int kind, const int * labels, size_t len) {
+    int label = this->km->find_relabel(kind, labels, len);
+    if (label >= 0)
+        return label;
+    bool inserted;
+    return this->unknown_table.insert(kind, labels, len, this->next_unknown_label, inserted);
+}
+
+template <typename Keys>
+int IncrementalVertexRelabel::relabel_neighbors(graphchi_vertex<VertexDataType, EdgeDataType> &vertex, const std::vector<int>& previous, bool edge_types,
+                                                scratch_arena &scratch) {
+    //every neighbor was labeled in the previous round: it has an edge, so it was scheduled in round 0 of the first wave it was in
+    return Keys::relabel(vertex, previous[vertex.id()], edge_types,
+                         [&](int i) { return previous[vertex.inedge(i)->vertex_id()]; },
+                         [&](int i) { return previous[vertex.outedge(i)->vertex_id()]; },
+                         [this](int kind, const int * labels, size_t len) { return this->lookup_relabel(kind, labels, len); },
+                         scratch);
+}
+
+void IncrementalVertexRelabel::update(graphchi_vertex<VertexDataType, EdgeDataType> &vertex, graphchi_context &gcontext) {
+    if (vertex.num_inedges() <= 0 && vertex.num_outedges() <= 0) {
+        //the other endpoints of its expired edges (in an earlier interval) may have removed the last edges of the vertex
+        if (this->window > 0 && vertex.id() < this->labels[0].size())
+            drop_vertex(vertex.id());
+        return;
+    }
+    this->wave_updates++;
+    int round = gcontext.iteration - this->wave_start;
+    int label;
+    if (round == 0 && this->window > 0) {
+        if (gcontext.iteration == 0) {
+            std::vector<timed_edge>& edges = this->base_edges[exec_thread_slot(gcontext.execthreads)];
+            for (int i = 0; i < vertex.num_outedges(); i++) {
+                timed_edge edge = {vertex.outedge(i)->get_data().time, vertex.id(), vertex.outedge(i)->vertex_id()};
+                edges.push_back(edge);
+            }
+        } else if (remove_expired_edges(vertex) == 0) {
+            drop_vertex(vertex.id());
+            return;
+        }
+    }
+    if (round == 0) {
+        int vertex_type = initial_vertex_type(vertex);
+        label = lookup_relabel(RELABEL_TYPE, &vertex_type, 1);
+    } else {
+        label = (this->*relabel)(vertex, this->labels[round - 1], round == 1, gcontext.scratch());
+    }
+
+    int& current = this->labels[round][vertex.id()];
+    if (label == current)
+        return;
+    if (current >= 0)
+        this->label_counts.add(current, -1);
+    this->label_counts.add(label);
+    current = label;
+    //the labels of the vertex and its neighbors in the next round depend on this one
+    if (round + 1 < this->nrounds) {
+        gcontext.scheduler->add_task(vertex.id());
+        for (int i = 0; i < vertex.num_inedges(); i++)
+            gcontext.scheduler->add_task(vertex.inedge(i)->vertex_id());
+        for (int i = 0; i < vertex.num_outedges(); i++)
+            gcontext.scheduler->add_task(vertex.outedge(i)->vertex_id());
+    }
+}
+
+int IncrementalVertexRelabel::remove_expired_edges(graphchi_vertex<VertexDataType, EdgeDataType> &vertex) {
+    int nleft = 0;
+    for (int i = 0; i < vertex.num_edges(); i++) {
+        if (expired(vertex.edge(i)->get_data().time))
+            vertex.remove_edge(i);
+        else
+            nleft++;
+    }
+    return nleft;
+}
+
+void IncrementalVertexRelabel::drop_vertex(vid_t vertex) {
+    for (int r = 0; r < this->nrounds; r++) {
+        int& current = this->labels[r][vertex];
+        if (current >= 0)
+            this->label_counts.add(current, -1);
+        current = -1;
+    }
+}
+
+void IncrementalVertexRelabel::before_iteration(int iteration, graphchi_context &gcontext) {
+    //the first wave: every vertex is scheduled
+    if (iteration == 0) {
+        this->labels.assign(this->nrounds, std::vector<int>(gcontext.nvertices, -1));
+        this->base_edges.assign(gcontext.execthreads + 1, std::vector<timed_edge>());
+    }
+    this->label_counts.reset(gcontext.execthreads);
+    if (iteration > this->wave_start) {
+        for (size_t i = 0; i < this->endpoints.size(); i++)
+            gcontext.scheduler->add_task(this->endpoints[i]);
+    }
+}
+
+void IncrementalVertexRelabel::after_iteration(int iteration, graphchi_context &gcontext) {
+    this->label_counts.merge_into(this->label_map);
+    if (iteration == 0) {
+        for (size_t t = 0; t < this->base_edges.size(); t++) {
+            for (size_t i = 0; i < this->base_edges[t].size(); i++) {
+                this->latest = std::max(this->latest, this->base_edges[t][i].time);
+                this->live_edges.push(this->base_edges[t][i]);
+            }
+        }
+        std::vector<std::vector<timed_edge>>().swap(this->base_edges);
+    }
+    if (iteration - this->wave_start < this->nrounds - 1)
+        return;
+    if (this->wave_finished)
+        this->wave_finished(this->wave_edges, this->wave_expired, this->wave_updates);
+    this->wave_start = iteration + 1;
+    //the engine stops when no vertex is scheduled for the next iteration
+    start_wave(gcontext);
+}
+
+void IncrementalVertexRelabel::advance_clock(const std::vector<streamed_edge>& burst) {
+    for (size_t i = 0; i < burst.size(); i++)
+        this->latest = std::max(this->latest, burst[i].data.time);
+}
+
+void IncrementalVertexRelabel::expire_edges() {
+    while (!this->live_edges.empty() && expired(this->live_edges.top().time)) {
+        const timed_edge& edge = this->live_edges.top();
+        this->endpoints.push_back(edge.src);
+        this->endpoints.push_back(edge.dst);
+        this->live_edges.pop();
+        this->wave_expired++;
+    }
+}
+
+bool IncrementalVertexRelabel::start_wave(graphchi_context &gcontext) {
+    this->wave_edges = 0;
+    this->wave_expired = 0;
+    this->wave_updates = 0;
+    this->endpoints.clear();
+    //new vertices are only added to the intervals of the engine when an iteration starts, so edges are added between waves
+    //(here, after the last round of one) rather than when they arrive
+    while (this->endpoints.empty()) {
+        std::vector<streamed_edge> burst;
+        if (!this->deferred.empty())
+            burst.swap(this->deferred);
+        else if (!this->bursts.pop(burst))
+            return false;
+        advance_clock(burst);
+        for (size_t i = 0; i < burst.size(); i++) {
+            const streamed_edge& edge = burst[i];
+            if (edge.src == edge.dst || expired(edge.data.time))
+                continue;
+            //the edge buffers of the engine are full; they are committed to the shards after this iteration.
+            //A commit leaves them empty, so this does not happen on the first edge of a wave
+            if (!this->engine.add_edge(edge.src, edge.dst, edge.data)) {
+                this->deferred.assign(burst.begin() + i, burst.end());
+                break;
+            }
+            this->wave_edges++;
+            this->endpoints.push_back(edge.src);
+            this->endpoints.push_back(edge.dst);
+            if (this->window > 0) {
+                timed_edge live = {edge.data.time, edge.src, edge.dst};
+                this->live_edges.push(live);
+            }
+        }
+        expire_edges();
+    }
+    std::sort(this->endpoints.begin(), this->endpoints.end());
+    this->endpoints.erase(std::unique(this->endpoints.begin(), this->endpoints.end()), this->endpoints.end());
+
+    if (!this->endpoints.empty() && this->endpoints.back() >= this->labels[0].size()) {
+        for (int r = 0; r < this->nrounds; r++)
+            this->labels[r].resize(this->endpoints.back() + 1, -1);
+    }
+    for (size_t i = 0; i < this->endpoints.size(); i++)
+        gcontext.scheduler->add_task(this->endpoints[i]);
+    logstream(LOG_INFO) << "Added " << this->wave_edges << " edges, expired " << this->wave_expired << ", " << this->endpoints.size()
+                        << " vertices scheduled" << std::endl;
+    return true;
+}
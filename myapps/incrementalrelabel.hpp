@@ -0,0 +1,202 @@
+//
+//  incrementalrelabel.hpp
+//  graphchi_xcode
+//
+
+#ifndef incrementalrelabel_hpp
+#define incrementalrelabel_hpp
+
+#include <vector>
+#include <deque>
+#include <queue>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <istream>
+#include "graphchi_basic_includes.hpp"
+#include "engine/dynamic_graphs/graphchi_dynamicgraph_engine.hpp"
+#include "kernelmaps.hpp"
+#include "labeltable.hpp"
+#include "global.h"
+#include "vertex.hpp"
+
+//Windowed relabeling removes expired edges with the deletions of the dynamic engine, which every GraphChi header has to
+//be compiled with: define SUPPORT_DELETIONS before the first include
+#ifndef SUPPORT_DELETIONS
+#error "incrementalrelabel.hpp needs SUPPORT_DELETIONS"
+#endif
+
+using namespace graphchi;
+
+struct streamed_edge {
+    vid_t src;
+    vid_t dst;
+    type_label data;
+};
+
+//an edge of the window, by the time it expires
+struct timed_edge {
+    int64_t time;
+    vid_t src;
+    vid_t dst;
+
+    bool operator>(const timed_edge& other) const {
+        return this->time > other.time;
+    }
+};
+
+//Bursts of new edges, handed from a reader thread to IncrementalVertexRelabel
+class EdgeBurstQueue {
+public:
+
+    void push(std::vector<streamed_edge>&& burst);
+
+    //no bursts will be pushed after the ones already queued
+    void close();
+
+    //waits for the next burst; returns false once the queue is closed and empty
+    bool pop(std::vector<streamed_edge>& burst);
+
+private:
+
+    std::deque<std::vector<streamed_edge>> bursts;
+
+    bool closed = false;
+
+    std::mutex lock;
+
+    std::condition_variable arrived;
+};
+
+//Read edges in the edge list format ("src dst src_type:dst_type:edge_type" per line) and queue them in bursts of burst_size edges
+//An empty line ends a burst early. The queue is closed at the end of the input
+void read_edge_bursts(std::istream& in, size_t burst_size, EdgeBurstQueue& bursts);
+
+//Weisfeiler-Lehman relabeling of a growing graph, on graphchi_dynamicgraph_engine with selective scheduling
+//The program runs in waves of nrounds engine iterations, one per update phase of VertexRelabelDetection (niters 4: the type
+//and one neighborhood relabel). The first wave labels the base graph. After every wave the next burst is added with add_edge,
+//and only the vertices whose label can change are scheduled: in round r those are the endpoints of the burst and the
+//vertices next to a vertex whose label changed in round r - 1, i.e. at most the r-hop neighborhood of the burst.
+//Labels of every round are kept per vertex, so that the histogram is updated by delta: a vertex whose label changes
+//takes one count from its old label and adds one to the new one
+//Neighbor labels are read from those per-vertex labels instead of the edges, so there is no swap phase and edges are never written
+//The histogram after a wave is the label map VertexRelabelDetection builds from scratch on the graph with all edges so far
+//(labels that are not in the kernelmap may get different ids; generate_count_array drops them either way)
+//With a window, the graph only keeps the edges of the last window units of time (type_label::time): the clock is the latest
+//timestamp seen, and every wave first removes the edges at or before latest - window. Their endpoints are scheduled like the
+//endpoints of new edges and remove the expired edges in round 0 (the engine skips them from round 1 on and drops them when it
+//rewrites a shard); a vertex left without edges takes its labels out of the histogram. The histogram is then the one of
+//the graph of the window. Edges of a burst that are already outside the window are not added. The base graph is labeled
+//whole; its old edges expire with the first burst
+struct IncrementalVertexRelabel : public GraphChiProgram<VertexDataType, EdgeDataType> {
+
+    typedef graphchi_dynamicgraph_engine<VertexDataType, EdgeDataType> engine_type;
+
+    //niters as for VertexRelabelDetection; label_map is the histogram kept up to date. window 0 keeps every edge
+    //(the engine must modify its edges otherwise, to remove the expired ones)
+    IncrementalVertexRelabel(engine_type& engine, EdgeBurstQueue& bursts, int niters, std::map<int, int>& label_map, int64_t window = 0);
+
+    //called when a wave has finished, with the number of edges of its burst (0 for the base graph), the number of edges
+    //that expired and the number of vertex updates it took
+    std::function<void(size_t nedges, size_t nexpired, size_t nupdates)> wave_finished;
+
+    void update(graphchi_vertex<VertexDataType, EdgeDataType> &vertex, graphchi_context &gcontext);
+
+    void before_iteration(int iteration, graphchi_context &gcontext);
+
+    void after_iteration(int iteration, graphchi_context &gcontext);
+
+    void before_exec_interval(vid_t window_st, vid_t window_en, graphchi_context &gcontext) {
+    }
+
+    void after_exec_interval(vid_t window_st, vid_t window_en, graphchi_context &gcontext) {
+    }
+
+private:
+
+    //same as VertexRelabelDetection::lookup_relabel
+    int lookup_relabel(int kind, const int * labels, size_t len);
+
+    typedef int (IncrementalVertexRelabel::*relabel_function)(graphchi_vertex<VertexDataType, EdgeDataType> &vertex, const std::vector<int>& previous, bool edge_types,
+                                                              scratch_arena &scratch);
+
+    //label of a vertex in a round after the first, from the labels of the previous round, with the key policy Keys
+    //(the keys are built in the scratch arena of the update thread)
+    template <typename Keys>
+    int relabel_neighbors(graphchi_vertex<VertexDataType, EdgeDataType> &vertex, const std::vector<int>& previous, bool edge_types, scratch_arena &scratch);
+
+    //sets relabel to relabel_neighbors of the key policy of a relabel variant (with_relabel_keys)
+    struct relabel_selection {
+        IncrementalVertexRelabel * program;
+
+        template <typename Keys>
+        void run() {
+            this->program->relabel = &IncrementalVertexRelabel::relabel_neighbors<Keys>;
+        }
+    };
+
+    relabel_function relabel;//relabel_neighbors of the relabel variant of the kernelmap
+
+    //add the next burst to the engine and schedule its endpoints; returns false if there are no more bursts
+    bool start_wave(graphchi_context &gcontext);
+
+    //advance the clock to the timestamps of burst
+    void advance_clock(const std::vector<streamed_edge>& burst);
+
+    bool expired(int64_t time) const {
+        return this->window > 0 && time <= this->latest - this->window;
+    }
+
+    //take the edges that left the window off the live edges and add their endpoints to the endpoints of the wave
+    void expire_edges();
+
+    //round 0 of a wave: remove the expired edges of the vertex; returns the number of edges left
+    int remove_expired_edges(graphchi_vertex<VertexDataType, EdgeDataType> &vertex);
+
+    //take the labels of a vertex that has no edges left out of the histogram
+    void drop_vertex(vid_t vertex);
+
+    engine_type& engine;
+
+    EdgeBurstQueue& bursts;
+
+    std::map<int, int>& label_map;
+
+    int nrounds;
+
+    int wave_start = 0;//engine iteration of round 0 of the current wave
+
+    size_t wave_edges = 0;
+
+    size_t wave_expired = 0;
+
+    std::atomic<size_t> wave_updates{0};
+
+    std::vector<vid_t> endpoints;//of the edges of the current burst. Their neighborhood changed, so they are updated in every round
+
+    std::vector<streamed_edge> deferred;//edges of a burst the engine could not buffer yet; they start the next wave
+
+    std::vector<std::vector<int>> labels;//labels[round][vertex], -1 if the vertex has not been labeled
+
+    KernelMaps* km = KernelMaps::get_instance();
+
+    ShardedLabelTable unknown_table;
+
+    std::atomic<int> next_unknown_label;
+
+    ThreadLabelCounts label_counts;
+
+    int64_t window;
+
+    int64_t latest;//the clock: the latest timestamp seen, -1 before the first one (timestamps are not negative)
+
+    std::priority_queue<timed_edge, std::vector<timed_edge>, std::greater<timed_edge>> live_edges;//of the window, oldest first
+
+    std::vector<std::vector<timed_edge>> base_edges;//edges of the base graph, per update thread (exec_thread_slot)
+};
+
+#include "incrementalrelabel.cpp"
+#endif /* incrementalrelabel_hpp */
@@ -18,6 +18,7 @@ KernelMaps* KernelMaps::get_instance() {
 
 KernelMaps::~KernelMaps() {
     this->relabel_map.clear();
+    this->relabel_table.clear();
     this->label_maps.clear();
     this->counter = 0;
     delete single_instance;
@@ -25,6 +26,7 @@ KernelMaps::~KernelMaps() {
 
 void KernelMaps::resetMaps() {
     this->relabel_map.clear();
+    this->relabel_table.clear();
     this->label_maps.clear();
     this ->counter = 0;
 }
@@ -48,6 +50,20 @@ int KernelMaps::insert_relabel(std::string label) {
     }
 }
 
+//same as above, but the label is a tuple of integer labels (see relabel_kind) instead of a string
+//new labels take the next value of the same counter, so ids are handed out in the same order as the string map would
+//thread safe
+int KernelMaps::insert_relabel(int kind, const int * labels, size_t len) {
+    bool inserted;
+    return this->relabel_table.insert(kind, labels, len, counter, inserted);
+}
+
+void KernelMaps::restore_relabel(int kind, const int * labels, size_t len, int id) {
+    bool inserted;
+    this->relabel_table.insert(kind, labels, len, id, inserted);
+    assert(inserted);
+}
+
 //insert int to label_map if it does not exist, or update the mapped value otherwise.
 //the label in the parameter is the mapped/relabeled label in the relabel map
 //always insert to the last map of the label_maps vector
@@ -61,20 +77,8 @@ void KernelMaps::insert_label(int label) {
     return;
 }
 
-std::vector<int> KernelMaps::generate_count_array(std::map<int, int>& map) {
-    std::vector<int> rtn;
-    std::map<int, int>::iterator itr = map.begin();
-    for (int i = 0; i < this->counter; i++) {
-        if (itr != map.end()) {
-            if (itr->first == i) {
-                rtn.push_back(itr->second);
-                itr++;
-            } else rtn.push_back(0);
-        } else {
-            rtn.push_back(0);
-        }
-    }
-    return rtn;
+sparse_count_array KernelMaps::generate_count_array(const std::map<int, int>& map) {
+    return sparse_count_array::from_label_map(map, this->counter);
 }
 
 //The rest functions are for debugging purpose only
@@ -83,6 +87,9 @@ void KernelMaps::print_relabel_map () {
     logstream(LOG_INFO) << "Printing relabel map..." << std::endl;
     for (map_itr = this->relabel_map.begin(); map_itr != this->relabel_map.end(); map_itr++)
         logstream(LOG_INFO) << map_itr->first << ":" << map_itr->second << std::endl;
+    this->relabel_table.for_each([](int kind, const int * labels, size_t len, int id) {
+        logstream(LOG_INFO) << LabelTable::key_string(kind, labels, len) << ":" << id << std::endl;
+    });
 }
 
 void KernelMaps::print_label_map (std::map<int, int>lmap) {
@@ -10,12 +10,82 @@
 #define kernelmaps_hpp
 
 #include <stdio.h>
+#include <omp.h>
+#include <atomic>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include "logger/logger.hpp"
+#include "labeltable.hpp"
+#include "countarray.hpp"
+
+//slot of the calling thread among the execthreads + 1 threads that can run vertex updates at the same time:
+//graphchi_engine::exec_updates runs the parallel-safe vertices in a nested parallel for (slots 0 to execthreads - 1)
+//and the rest serially in a parallel section next to it (slot execthreads)
+inline int exec_thread_slot(int execthreads) {
+    if (omp_get_level() > 1) {
+        assert(omp_get_thread_num() < execthreads);
+        return omp_get_thread_num();
+    }
+    return execthreads;
+}
+
+//Label histograms kept per update thread, so that counting labels does not need a lock
+//Call reset before an iteration and merge_into after it
+//Counts can be negative (a label a vertex no longer has); labels whose count drops to 0 are removed from the label map
+class ThreadLabelCounts {
+public:
+
+    void reset(int execthreads) {
+        this->counts.assign(execthreads + 1, std::unordered_map<int, int>());
+        this->execthreads = execthreads;
+    }
+
+    void add(int label, int count = 1) {
+        this->counts[exec_thread_slot(this->execthreads)][label] += count;
+    }
+
+    //add the labels counted (with a count other than 0) on any thread to labels
+    void collect_labels(std::unordered_set<int>& labels) const {
+        for (size_t i = 0; i < this->counts.size(); i++)
+            for (std::unordered_map<int, int>::const_iterator itr = this->counts[i].begin(); itr != this->counts[i].end(); itr++)
+                if (itr->second != 0)
+                    labels.insert(itr->first);
+    }
+
+    //add all per-thread counts to the label map and clear them
+    void merge_into(std::map<int, int>& label_map) {
+        for (size_t i = 0; i < this->counts.size(); i++) {
+            for (std::unordered_map<int, int>::iterator itr = this->counts[i].begin(); itr != this->counts[i].end(); itr++) {
+                int& count = label_map[itr->first];
+                count += itr->second;
+                if (count == 0)
+                    label_map.erase(itr->first);
+            }
+            this->counts[i].clear();
+        }
+    }
+
+private:
+
+    std::vector<std::unordered_map<int, int>> counts;
+
+    int execthreads;
+};
+
+//Relabel variants, the key policies of the relabel vertex programs (vertex.cpp). The README describes them as the VERSION and
+//TAKEEDGELABEL settings of vertexlabel_static. A relabel table only fits graphs relabeled with the variant it was built with
+enum relabel_variant {
+    RELABEL_EDGE_AWARE = 0,//VERSION 2
+    RELABEL_DIRECTED = 1,//VERSION 1
+    RELABEL_DIRECTED_EDGE_LABELS = 2,//VERSION 1, TAKEEDGELABEL 1
+    RELABEL_DIRECTIONLESS = 3,//VERSION 0
+    RELABEL_DIRECTIONLESS_EDGE_LABELS = 4//VERSION 0, TAKEEDGELABEL 1
+};
 
 //We use singleton design pattern
-//not thread safe
+//insert_relabel/find_relabel on label tuples are thread safe; the rest is not
 
 class KernelMaps {
 public:
@@ -27,21 +97,67 @@ public:
     void resetMaps();
     
     void insert_label_map();
+    
+    //drop the last label map (see relabel_learning, which moves its counts into an earlier one)
+    void pop_label_map() {
+        this->label_maps.pop_back();
+    }
         
     int insert_relabel(std::string label);
     
+    int insert_relabel(int kind, const int * labels, size_t len);
+    
+    int find_relabel(int kind, const int * labels, size_t len) {
+        return this->relabel_table.find(kind, labels, len);
+    }
+    
+    //insert a label tuple with the id it had in a saved relabel table (see modelsnapshot.hpp)
+    //the counter is not moved past it; call set_counter once the whole table is restored
+    void restore_relabel(int kind, const int * labels, size_t len, int id);
+    
+    //calls f(kind, labels, len, id) on every tuple in the relabel table, in id order
+    template <typename F>
+    void for_each_relabel(F f) {
+        this->relabel_table.for_each(f);
+    }
+    
     void insert_label(int label);
     
-    std::vector<int> generate_count_array(std::map<int, int>& map);
+    sparse_count_array generate_count_array(const std::map<int, int>& map);
     
-    std::vector<std::map<int, int>> get_label_maps () {
+    const std::vector<std::map<int, int>>& get_label_maps () const {
         return this->label_maps;
     }
     
+    std::map<int, int>& label_map(size_t i) {
+        return this->label_maps[i];
+    }
+    
+    //the map insert_label inserts to
+    std::map<int, int>& last_label_map() {
+        return this->label_maps.back();
+    }
+    
     std::map<std::string, int> get_relabel_map () {
         return this->relabel_map;
     }
     
+    int get_counter() {
+        return this->counter;
+    }
+    
+    void set_counter(int counter) {
+        this->counter = counter;
+    }
+    
+    int get_relabel_variant() const {
+        return this->variant;
+    }
+    
+    void set_relabel_variant(int variant) {
+        this->variant = variant;
+    }
+    
     void print_relabel_map();
     
     void print_label_map(std::map<int, int>lmap);
@@ -56,9 +172,13 @@ private:
     
     std::map<std::string, int> relabel_map;//a global relabel map
     
+    ShardedLabelTable relabel_table;//a global relabel map keyed by integer label tuples. It shares the counter with relabel_map
+    
     std::vector<std::map<int, int>> label_maps;//a vector that holds all label maps
     
-    int counter;//a counter to facilitate relabeling. This is also the size of the relabel map
+    std::atomic<int> counter;//a counter to facilitate relabeling. This is also the size of the relabel map
+    
+    int variant = RELABEL_EDGE_AWARE;//relabel_variant the relabel map is built with
 };
 
 #include "kernelmaps.cpp"
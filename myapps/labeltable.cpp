@@ -0,0 +1,158 @@
+//
+//  labeltable.cpp
+//  graphchi_xcode
+//
+
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+#include <sstream>
+#include "labeltable.hpp"
+
+//multiply-xorshift mixing over 32-bit words, finished with the murmur3 64-bit finalizer
+uint64_t hash_label_tuple(int kind, const int * labels, size_t len) {
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ ((uint64_t)kind << 56) ^ (uint64_t)len;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (uint32_t)labels[i];
+        h *= 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 32;
+    }
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+LabelTable::LabelTable(size_t capacity) {
+    size_t cap = 16;
+    while (cap < capacity)
+        cap <<= 1;
+    this->slots.assign(cap, -1);
+    this->mask = cap - 1;
+}
+
+size_t LabelTable::probe(uint64_t hash, int kind, const int * labels, size_t len) const {
+    size_t pos = hash & this->mask;
+    while (this->slots[pos] >= 0) {
+        const entry & e = this->entries[this->slots[pos]];
+        if (e.hash == hash && e.kind == kind && (size_t)e.len == len
+            && memcmp(this->pool.data() + e.offset, labels, len * sizeof(int)) == 0)
+            return pos;
+        pos = (pos + 1) & this->mask;
+    }
+    return pos;
+}
+
+int LabelTable::insert(int kind, const int * labels, size_t len, int id, bool & inserted) {
+    return insert_hashed(hash_label_tuple(kind, labels, len), kind, labels, len, id, inserted);
+}
+
+int LabelTable::insert_hashed(uint64_t hash, int kind, const int * labels, size_t len, int id, bool & inserted) {
+    size_t pos = probe(hash, kind, labels, len);
+    if (this->slots[pos] >= 0) {
+        inserted = false;
+        return this->entries[this->slots[pos]].id;
+    }
+    entry e;
+    e.hash = hash;
+    e.offset = this->pool.size();
+    e.len = (int)len;
+    e.kind = kind;
+    e.id = id;
+    this->pool.insert(this->pool.end(), labels, labels + len);
+    this->slots[pos] = (int)this->entries.size();
+    this->entries.push_back(e);
+    //keep the load factor under 1/2 so that probe sequences stay short
+    if (this->entries.size() * 2 > this->slots.size())
+        grow();
+    inserted = true;
+    return id;
+}
+
+int LabelTable::find(int kind, const int * labels, size_t len) const {
+    return find_hashed(hash_label_tuple(kind, labels, len), kind, labels, len);
+}
+
+int LabelTable::find_hashed(uint64_t hash, int kind, const int * labels, size_t len) const {
+    size_t pos = probe(hash, kind, labels, len);
+    if (this->slots[pos] >= 0)
+        return this->entries[this->slots[pos]].id;
+    return -1;
+}
+
+void LabelTable::clear() {
+    this->entries.clear();
+    this->pool.clear();
+    std::fill(this->slots.begin(), this->slots.end(), -1);
+}
+
+void LabelTable::grow() {
+    size_t cap = this->slots.size() * 2;
+    this->slots.assign(cap, -1);
+    this->mask = cap - 1;
+    for (size_t i = 0; i < this->entries.size(); i++) {
+        size_t pos = this->entries[i].hash & this->mask;
+        while (this->slots[pos] >= 0)
+            pos = (pos + 1) & this->mask;
+        this->slots[pos] = (int)i;
+    }
+}
+
+std::string LabelTable::key_string(int kind, const int * labels, size_t len) {
+    std::stringstream out;
+    if (kind == RELABEL_TYPE) {
+        assert(len == 1);
+        out << labels[0];
+    } else if (kind == RELABEL_COMBINED) {
+        assert(len == 2);
+        out << labels[0] << "," << labels[1];
+    } else {
+        assert(len >= 1);
+        out << labels[0] << ",";
+        for (size_t i = 1; i < len; i++)
+            out << labels[i] << " ";
+    }
+    return out.str();
+}
+
+int ShardedLabelTable::insert(int kind, const int * labels, size_t len, std::atomic<int> & counter, bool & inserted) {
+    uint64_t hash = hash_label_tuple(kind, labels, len);
+    shard & s = shard_of(hash);
+    std::lock_guard<std::mutex> guard(s.lock);
+    int id = s.table.find_hashed(hash, kind, labels, len);
+    if (id >= 0) {
+        inserted = false;
+        return id;
+    }
+    return s.table.insert_hashed(hash, kind, labels, len, counter++, inserted);
+}
+
+int ShardedLabelTable::insert(int kind, const int * labels, size_t len, int id, bool & inserted) {
+    uint64_t hash = hash_label_tuple(kind, labels, len);
+    shard & s = shard_of(hash);
+    std::lock_guard<std::mutex> guard(s.lock);
+    return s.table.insert_hashed(hash, kind, labels, len, id, inserted);
+}
+
+int ShardedLabelTable::find(int kind, const int * labels, size_t len) {
+    uint64_t hash = hash_label_tuple(kind, labels, len);
+    shard & s = shard_of(hash);
+    std::lock_guard<std::mutex> guard(s.lock);
+    return s.table.find_hashed(hash, kind, labels, len);
+}
+
+size_t ShardedLabelTable::size() {
+    size_t rtn = 0;
+    for (int i = 0; i < NUM_SHARDS; i++) {
+        std::lock_guard<std::mutex> guard(this->shards[i].lock);
+        rtn += this->shards[i].table.size();
+    }
+    return rtn;
+}
+
+void ShardedLabelTable::clear() {
+    for (int i = 0; i < NUM_SHARDS; i++) {
+        std::lock_guard<std::mutex> guard(this->shards[i].lock);
+        this->shards[i].table.clear();
+    }
+}
@@ -0,0 +1,143 @@
+//
+//  labeltable.hpp
+//  graphchi_xcode
+//
+
+#ifndef labeltable_hpp
+#define labeltable_hpp
+
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//Kinds of relabel keys. The kind is part of the key, so that tuples of different kinds never match.
+//These mirror the strings the string-keyed relabel map used to build:
+//RELABEL_TYPE: "t" (the w3c type of a vertex in the first iteration)
+//RELABEL_NEIGHBOR: "self,n1 n2 ... " (own label followed by the sorted neighbor labels)
+//RELABEL_COMBINED: "in,out" (the relabeled incoming and outgoing labels of a vertex)
+enum relabel_kind {
+    RELABEL_TYPE = 0,
+    RELABEL_NEIGHBOR = 1,
+    RELABEL_COMBINED = 2
+};
+
+//64-bit hash of a label tuple of the given kind
+uint64_t hash_label_tuple(int kind, const int * labels, size_t len);
+
+//Open-addressing (linear probing) hash table from integer label tuples to relabeled ids
+//Keys are copied into a single contiguous pool, so an insertion does not allocate per key
+//not thread safe
+class LabelTable {
+public:
+
+    LabelTable(size_t capacity = 1024);
+
+    //insert the tuple with the given id if it does not exist in the table and return the id
+    //if it does exist, return the existing id. inserted tells which case happened
+    int insert(int kind, const int * labels, size_t len, int id, bool & inserted);
+
+    //same as above, with the hash_label_tuple value of the tuple already computed
+    int insert_hashed(uint64_t hash, int kind, const int * labels, size_t len, int id, bool & inserted);
+
+    //return the id of the tuple, or -1 if the tuple is not in the table
+    int find(int kind, const int * labels, size_t len) const;
+
+    int find_hashed(uint64_t hash, int kind, const int * labels, size_t len) const;
+
+    size_t size() const {
+        return this->entries.size();
+    }
+
+    void clear();
+
+    //calls f(kind, labels, len, id) on every tuple in the table, in insertion order
+    template <typename F>
+    void for_each(F f) const {
+        for (std::vector<entry>::const_iterator itr = this->entries.begin(); itr != this->entries.end(); itr++) {
+            f(itr->kind, this->pool.data() + itr->offset, (size_t)itr->len, itr->id);
+        }
+    }
+
+    //the string the string-keyed relabel map would have used for this tuple
+    static std::string key_string(int kind, const int * labels, size_t len);
+
+private:
+
+    struct entry {
+        uint64_t hash;
+        size_t offset;//position of the tuple in the pool
+        int len;
+        int kind;
+        int id;
+    };
+
+    //position of the tuple in slots: either its entry or the empty slot where it belongs
+    size_t probe(uint64_t hash, int kind, const int * labels, size_t len) const;
+
+    void grow();
+
+    std::vector<entry> entries;//in insertion order
+
+    std::vector<int> slots;//index into entries, -1 if the slot is empty
+
+    std::vector<int> pool;//all tuples back to back
+
+    size_t mask;//capacity - 1, capacity is always a power of two
+};
+
+//LabelTable split into independently locked shards picked by the top bits of the tuple hash
+//thread safe: threads relabeling different neighborhoods rarely wait on the same lock
+//New tuples take their id from a counter supplied by the caller, so several tables (or a table and the string relabel map) can share one id space
+class ShardedLabelTable {
+public:
+
+    static const int NUM_SHARDS = 64;
+
+    //insert the tuple if it does not exist in the table and return its id; a new tuple gets the next value of counter
+    int insert(int kind, const int * labels, size_t len, std::atomic<int> & counter, bool & inserted);
+
+    //insert the tuple with the given id if it does not exist in the table (to restore a saved table) and return its id
+    int insert(int kind, const int * labels, size_t len, int id, bool & inserted);
+
+    //return the id of the tuple, or -1 if the tuple is not in the table
+    int find(int kind, const int * labels, size_t len);
+
+    size_t size();
+
+    void clear();
+
+    //calls f(kind, labels, len, id) on every tuple in the table, in id order
+    //not thread safe
+    template <typename F>
+    void for_each(F f) {
+        std::vector<std::pair<int, std::pair<int, std::vector<int>>>> all;
+        for (int i = 0; i < NUM_SHARDS; i++) {
+            this->shards[i].table.for_each([&all](int kind, const int * labels, size_t len, int id) {
+                all.push_back(std::make_pair(id, std::make_pair(kind, std::vector<int>(labels, labels + len))));
+            });
+        }
+        std::sort(all.begin(), all.end());
+        for (size_t i = 0; i < all.size(); i++)
+            f(all[i].second.first, all[i].second.second.data(), all[i].second.second.size(), all[i].first);
+    }
+
+private:
+
+    struct shard {
+        std::mutex lock;
+        LabelTable table;
+        shard() : table(64) {}
+    };
+
+    shard & shard_of(uint64_t hash) {
+        return this->shards[hash >> 58];//NUM_SHARDS = 2^6
+    }
+
+    shard shards[NUM_SHARDS];
+};
+
+#include "labeltable.cpp"
+#endif /* labeltable_hpp */
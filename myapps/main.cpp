@@ -12,6 +12,8 @@
 #include <map>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include <cstdlib>
 #include <vector>
 #include <sstream>
@@ -19,10 +21,22 @@
 #include <cmath>
 #include <algorithm>
 #include <stdio.h>
+#include <set>
+#include <fstream>
+#include <chrono>
+#include <dirent.h>
+#include <unistd.h>
+#include <limits>
 #include "kernelmaps.hpp"
 #include "profile.hpp"
+#include "distancekernels.hpp"
+#include "distancematrix.hpp"
 #include "global.h"
 #include "vertex.hpp"
+#include "modelsnapshot.hpp"
+#include "graphunion.hpp"
+#include "scoring.hpp"
+#include "provedges.hpp"
 #include "graphchi_basic_includes.hpp"
 #include "logger/logger.hpp"
 
@@ -33,120 +47,127 @@ using namespace graphchi;
 #define EUCLIDEAN 2
 #define METRIC 1 //for old simple normal distribution analysis only. Deprecated
 
-
-// Parse the type value in the file to the type_label structure for reading
-void parse(type_label &x, const char * s) {
-    char * ss = (char *) s;
-    char delims[] = ":";
-    char * t;
-    t = strtok(ss, delims);
-    if (t == NULL)
-        logstream(LOG_FATAL) << "Source Type info does not exist" << std::endl;
-    assert(t != NULL);
-    x.new_src = atoi(t);
-    //TODO: We can make sure type value is never 0 so we can check if parse goes wrong here
-    t = strtok(NULL, delims);
-    if (t == NULL)
-        logstream(LOG_FATAL) << "Destination Type info does not exist" << std::endl;
-    assert (t != NULL);
-    x.new_dst = atoi(t);
-    t = strtok(NULL, delims);
-    if (t == NULL)
-        logstream(LOG_FATAL) << "Edge Type info does not exist" << std::endl;
-    assert (t != NULL);
-    x.edge = atoi(t);
-    t = strtok(NULL, delims);
-    if (t != NULL)
-        logstream(LOG_FATAL) << "Extra info will be ignored" << std::endl;
-    return;
+//metric <kl|hellinger|euclidean>: the distance the instances are clustered and compared with
+int parse_metric(const std::string& name) {
+    if (name == "kl")
+        return KULLBACKLEIBLER;
+    if (name == "hellinger")
+        return HELLINGER;
+    if (name == "euclidean")
+        return EUCLIDEAN;
+    logstream(LOG_FATAL) << "Unknown metric " << name << " (kl, hellinger or euclidean)" << std::endl;
+    assert(false);
+    return KULLBACKLEIBLER;
 }
 
-int main(int argc, const char ** argv) {
-    /* GraphChi initialization will read the command line
-     arguments and the configuration file. */
-    graphchi_init(argc, argv);
-    
-    /* Metrics object for keeping track of performance counters
-     and other information. Currently required. */
-    metrics m("Detection Framework");
-    
-    /* Basic arguments for application */
-    //First, we must know how many graphs will be used for computation:
-    int num_graphs = get_option_int("ngraphs");
-    //This tells us how many instances are only part of the monitoring, not the learning
-    //Therefore the learning graphs would be (num_graphs - num_monitor)
-    int num_monitor = get_option_int("nmonitor");
-    //We then use the for loop to get all the filenames, and store them in an array
-    std::string filenames[num_graphs] = {};
-    for (int i = 0; i < num_graphs; i++) {
-        std::string f_string;
-        std::stringstream f_out;
-        f_out << i;
-        f_string = f_out.str();
-        const std::string name_of_file = "file" + f_string;
-        filenames[i] = get_option_string(name_of_file.c_str());
-    }
-    
-    //TODO: Make iterations dynamic based on convergence instead
-    int niters           = get_option_int("niters", 4); // Number of iterations, or default of 4
-    bool scheduler       = false;
-    
-    /* Detect the number of shards or preprocess an input to create them */
-    //for each file, detect shards or preprocess an input to create them
-    //put results in an array
-    int nshards_arr[num_graphs] = {};
-    for (int i = 0; i < num_graphs; i++) {
-        nshards_arr[i] = convert_if_notexists<EdgeDataType>(filenames[i], get_option_string("nshards", "auto"));
+
+//Relabel the first num_learning instances into new label maps of the kernelmap (building the relabel table); with converge
+//every run ends once its labels stop refining. Returns the rounds of every run (one per instance, or per batch union).
+//With rerun only the runs it marks are relabeled again, into the label maps they filled before (which are cleared first); their
+//shards (or those of their unions) are built again first, since the earlier relabeling overwrote their types
+std::vector<int> relabel_learning(const std::string * filenames, const int * nshards_arr, int num_learning, int niters, bool scheduler,
+                                  metrics& m, bool converge, const std::vector<bool> * rerun = NULL) {
+    KernelMaps* km = KernelMaps::get_instance();
+    std::string nshards_string = get_option_string("nshards", "auto");
+    std::vector<int> rounds;
+    
+    //batch <n>: relabel them n at a time, each n graphs as one disjoint union (one engine run instead of n)
+    int batch = get_option_int("batch", 0);
+    if (batch > 0) {
+        for (int first = 0; first < num_learning; first += batch) {
+            int n = std::min(batch, num_learning - first);
+            if (rerun != NULL && !(*rerun)[first / batch]) {
+                rounds.push_back(0);
+                continue;
+            }
+            std::stringstream union_file;
+            union_file << filenames[first] << ".union" << n;
+            graph_union batch_graph(std::vector<std::string>(filenames + first, filenames + first + n), union_file.str());
+            int union_nshards = rerun != NULL ? reshard_graph(batch_graph.filename(), nshards_string)
+                : convert_graph_if_notexists(batch_graph.filename(), nshards_string);
+            size_t first_label_map = first;
+            for (int i = 0; i < n; i++) {
+                if (rerun != NULL)
+                    km->label_map(first + i).clear();
+                else
+                    km->insert_label_map();
+            }
+            
+            graphchi_engine<VertexDataType, EdgeDataType> engine(batch_graph.filename(), union_nshards, scheduler, m);
+            rounds.push_back(run_relabel(engine, niters, &batch_graph, first_label_map, converge));
+        }
+    } else {
+        for (int i = 0; i < num_learning; i++) {
+            if (rerun != NULL && !(*rerun)[i]) {
+                rounds.push_back(0);
+                continue;
+            }
+            km->insert_label_map();
+            
+            int nshards = rerun != NULL ? reshard_graph(filenames[i], nshards_string) : nshards_arr[i];
+            graphchi_engine<VertexDataType, EdgeDataType> engine(filenames[i], nshards, scheduler, m);
+            rounds.push_back(run_relabel(engine, niters, NULL, 0, converge));
+            //the run counts into the last label map
+            if (rerun != NULL) {
+                km->label_map(i).swap(km->last_label_map());
+                km->pop_label_map();
+            }
+        }
     }
+    return rounds;
+}
 
-    /* Run */
-    //create the single instance of KernelMap
+//Learning stage: relabel the first num_learning instances (building the kernelmap), cluster their count arrays and put
+//the clusters in the profile
+//converge 1: the learning instances are first relabeled until their labels stop refining, to find the last round in which one
+//of them still refines. Every instance, learning and monitored, is then relabeled for exactly that many rounds (niters is set
+//to them), so that all count arrays hold the labels of the same rounds
+void learn_profile(profile& pf, const std::string * filenames, const int * nshards_arr, int num_learning, int& niters, bool converge,
+                   bool scheduler, metrics& m) {
     KernelMaps* km = KernelMaps::get_instance();
-    km->resetMaps();
-    
-    //create a tentative profile
-    profile pf;
-    
-    pf.reset_arrays();
     
     //Generate label maps of all learning instances
-    for (int i = 0; i < num_graphs - num_monitor; i++) {
-        km->insert_label_map();
-        
-        VertexRelabel program;
-        graphchi_engine<VertexDataType, EdgeDataType> engine(filenames[i], nshards_arr[i], scheduler, m);
-        engine.run(program, niters);
+    std::vector<int> rounds = relabel_learning(filenames, nshards_arr, num_learning, niters, scheduler, m, converge);
+    if (converge && !rounds.empty()) {
+        int max_rounds = *std::max_element(rounds.begin(), rounds.end());
+        logstream(LOG_INFO) << "The learning instances stop refining after " << max_rounds << " relabel rounds; every instance is relabeled for as many" << std::endl;
+        niters = 2 * max_rounds;
+        //the runs that stopped before miss the labels of the later rounds: relabel only them again. The relabel table keeps its
+        //labels, which the runs that went on to max_rounds put there the same way
+        std::vector<bool> rerun(rounds.size());
+        for (size_t r = 0; r < rounds.size(); r++)
+            rerun[r] = rounds[r] < max_rounds;
+        if (std::find(rerun.begin(), rerun.end(), true) != rerun.end())
+            relabel_learning(filenames, nshards_arr, num_learning, niters, scheduler, m, false, &rerun);
     }
     
-    //generate count arrays and put them in the profile
-    std::vector<std::map<int, int>> label_maps = km->get_label_maps();
-    assert((int)label_maps.size() == num_graphs - num_monitor);
-
-    for (std::vector<std::map<int, int>>::iterator it = label_maps.begin(); it != label_maps.end(); it++) {
-        pf.add_array(km->generate_count_array(*it));
+    //generate count arrays of all learning instances
+    //they are put in the profile only once clustering decides which ones belong to it
+    const std::vector<std::map<int, int>>& label_maps = km->get_label_maps();
+    assert((int)label_maps.size() == num_learning);
+    std::vector<sparse_count_array> count_arrays;
+    count_arrays.reserve(label_maps.size());
+    for (std::vector<std::map<int, int>>::const_iterator it = label_maps.begin(); it != label_maps.end(); it++) {
+        count_arrays.push_back(km->generate_count_array(*it));
     }
 
     //calculate distance matrix between every two count arrays
     //the matrix is implemented as a vector. With 3 graphs, A, B, and C, we have [D(A, B), D(A, C), D(B, C)]
     std::vector<double> distance_matrix;
-    //get all the count arrays
-    std::vector<std::vector<int>> count_arrays = pf.get_count_arrays();
     
     //print out all count arrays - debugging
-//    for (std::vector<std::vector<int>>::iterator itr = count_arrays.begin(); itr != count_arrays.end(); itr++) {
+//    for (std::vector<sparse_count_array>::iterator itr = count_arrays.begin(); itr != count_arrays.end(); itr++) {
 //        std::cout << "Count Array: ";
-//        for (std::vector<int>::iterator itr2 = itr->begin(); itr2 != itr->end(); itr2++) {
-//            std::cout << *itr2 << " ";
+//        for (size_t itr2 = 0; itr2 < itr->index.size(); itr2++) {
+//            std::cout << itr->index[itr2] << ":" << itr->value[itr2] << " ";
 //        }
 //        std::cout << std::endl;
 //    }
     
-    for (int i = 0 ; i < num_graphs - num_monitor; i++) {
-        for (int j = 1; j < num_graphs - num_monitor - i; j++) {
-            double distance = pf.calculate_distance(KULLBACKLEIBLER, count_arrays[i], count_arrays[i+j]);
-            distance_matrix.push_back(distance);
-        }
-    }
+    DistanceMatrix matrix(pf.get_metric());
+    matrix.append(count_arrays);
+    distance_matrix = matrix.condensed();
+    logstream(LOG_INFO) << "Distance kernels: " << kernel_isa_name(best_kernel_isa()) << std::endl;
     
     //print out distance matrix
 //    std::cout << "Distance matrix: ";
@@ -161,10 +182,11 @@ int main(int argc, const char ** argv) {
     //We cluster pair-wise distances
     //The number of cluster will be used as the value k when clustering distributions
     //This algorithm also helps to determine the inital centroid value to use
-    std::pair<std::vector<std::vector<int>>, std::vector<std::vector<double>>> cluster_prior_results = kmeans_prior(num_graphs - num_monitor, distance_matrix);
-    std::vector<std::vector<int>> cluster_prior = cluster_prior_results.first;
-    //prior_distance not used for now
-    std::vector<std::vector<double>> prior_distance = cluster_prior_results.second;
+    //kmeans_max_iters <n>: stop every k-means after n passes even if it has not converged (0, the default: no cap)
+    int max_iterations = get_option_int("kmeans_max_iters", 0);
+    std::pair<std::vector<std::vector<int>>, std::vector<std::vector<double>>> cluster_prior_results = kmeans_prior(num_learning, distance_matrix, max_iterations);
+    std::vector<std::vector<int>>& cluster_prior = cluster_prior_results.first;
+    //the distances (cluster_prior_results.second) are not used for now
     
     //obtain the value of k for later clustering of distributions
     int total_number_of_valid_clusters_estimate = 0;
@@ -188,9 +210,9 @@ int main(int argc, const char ** argv) {
         std::cout << "Prior Cluster: ";
         std::map<int, int> temp;
         for (std::vector<int>::iterator itr2 = itr->begin(); itr2 != itr->end(); itr2++) {
-            for (int x = 0; x < num_graphs - num_monitor - 1; x++) {
-                for (int y = 0; y < num_graphs - num_monitor - 1 - x; y++) {
-                    if ((((( (num_graphs - num_monitor - 1) + ( num_graphs - num_monitor - x )) * x ) / 2 ) + y ) == *itr2) {
+            for (int x = 0; x < num_learning - 1; x++) {
+                for (int y = 0; y < num_learning - 1 - x; y++) {
+                    if ((((( (num_learning - 1) + ( num_learning - x )) * x ) / 2 ) + y ) == *itr2) {
                         std::cout << x << "-" << x + 1 + y << " ";
                         std::pair<std::map<int,int>::iterator,bool> ret;
                         ret = temp.insert ( std::pair<int,int>(x,1) );
@@ -241,22 +263,27 @@ int main(int argc, const char ** argv) {
 //    }
 //    std::cout << std::endl;
     
+    //kmeans_seeding plusplus: seed the clustering of distributions with k-means++ rather than with the instances of the prior clusters
+    //(k is still the estimate of the prior)
+    if (get_option_string("kmeans_seeding", "prior") == "plusplus")
+        cluster_ids = kmeans_engine(count_arrays).plus_plus_seeds(total_number_of_valid_clusters_estimate);
+
     //this is the centroids of all the clusters in the profile
-    std::vector<std::vector<int>> final_centroids;
+    std::vector<sparse_count_array> final_centroids;
 
-    std::pair<std::vector<std::vector<int>>, std::vector<std::vector<double>>> cluster_results = kmeans(total_number_of_valid_clusters_estimate, cluster_ids, count_arrays, final_centroids);
+    std::pair<std::vector<std::vector<int>>, std::vector<std::vector<double>>> cluster_results = kmeans(total_number_of_valid_clusters_estimate, cluster_ids, count_arrays, final_centroids, max_iterations, pf.get_metric());
     
     //for debugging: print the centroids of the results:
-//    for (std::vector<std::vector<int>>::iterator it = final_centroids.begin(); it != final_centroids.end(); it++) {
+//    for (std::vector<sparse_count_array>::iterator it = final_centroids.begin(); it != final_centroids.end(); it++) {
 //        std::cout << "Centroids:" << std::endl;
-//        for (std::vector<int>::iterator itr2 = it->begin(); itr2 != it->end(); itr2++) {
-//            std::cout << *itr2 << " ";
+//        for (size_t itr2 = 0; itr2 < it->index.size(); itr2++) {
+//            std::cout << it->index[itr2] << ":" << it->value[itr2] << " ";
 //        }
 //        std::cout << std::endl;
 //    }
     
-    std::vector<std::vector<int>> cluster = cluster_results.first;
-    std::vector<std::vector<double>> cluster_distances = cluster_results.second;
+    std::vector<std::vector<int>>& cluster = cluster_results.first;
+    std::vector<std::vector<double>>& cluster_distances = cluster_results.second;
     
     //for debugging: print out elements in a cluster
     for (std::vector<std::vector<int>>::iterator it = cluster.begin(); it != cluster.end(); it++) {
@@ -280,17 +307,18 @@ int main(int argc, const char ** argv) {
     pf.reset_count_arrays();
     int number_of_clusters = 0;
     for (size_t i = 0; i < cluster.size(); i++) {
-        if (cluster[i].size() > (num_graphs - num_monitor) * 0.2) {
+        if (cluster[i].size() > (num_learning) * 0.2) {
             number_of_clusters++;
-            pf.add_centroid(final_centroids[i]);
+            pf.add_centroid(std::move(final_centroids[i]));
             double max_dis = 0.0;
             for (std::vector<double>::iterator it = cluster_distances[i].begin(); it != cluster_distances[i].end(); it++) {
                 if (*it > max_dis)
                     max_dis = *it;
             }
             pf.add_max_distance_from_centroid(max_dis);
+            //every instance is in exactly one cluster and count_arrays is not used after this
             for (size_t j = 0; j < cluster[i].size(); j++) {
-                pf.add_array(count_arrays[cluster[i][j]]);
+                pf.add_array(std::move(count_arrays[cluster[i][j]]));
             }
         }
     }
@@ -303,89 +331,248 @@ int main(int argc, const char ** argv) {
     std::cout << "Final size of centroids: " << pf.get_centroids().size() << std::endl;
     std::cout << "Final size of distances: " << pf.get_distances().size() << std::endl;
     std::cout << "Final number of count array in the profile: " << pf.get_count_arrays().size() << std::endl;
-    std::vector<std::vector<int>> profile_centroids = pf.get_centroids();
-//    for (std::vector<std::vector<int>>::iterator it = profile_centroids.begin(); it != profile_centroids.end(); it++) {
+//    for (std::vector<sparse_count_array>::const_iterator it = pf.get_centroids().begin(); it != pf.get_centroids().end(); it++) {
 //        std::cout << "Centroids: ";
-//        for (std::vector<int>::iterator itr2 = it->begin(); itr2 != it->end(); itr2++) {
-//            std::cout << *itr2 << " ";
+//        for (size_t itr2 = 0; itr2 < it->index.size(); itr2++) {
+//            std::cout << it->index[itr2] << ":" << it->value[itr2] << " ";
 //        }
 //        std::cout << std::endl;
 //    }
-    std::vector<double> profile_distances = pf.get_distances();
-    std::cout << "Max distance of each cluster: ";
-    for (std::vector<double>::iterator it = profile_distances.begin(); it != profile_distances.end(); it++) {
-        std::cout << *it << " ";
+}
+
+//Detection of one monitored instance: relabel it with the kernelmap of the learning stage and score its count array (score_instance)
+bool detect_instance(profile& pf, const std::string& filename, int nshards, int niters, bool scheduler, metrics& m, bool update_profile,
+                     std::ostream& out = std::cout) {
+    KernelMaps* km = KernelMaps::get_instance();
+    graphchi_engine<VertexDataType, EdgeDataType> engine(filename, nshards, scheduler, m);
+    monitor_profile monitored;
+    run_relabel_detection(engine, niters, monitored.label_map, out);
+    
+    monitored.count_array = km->generate_count_array(monitored.label_map);
+    return score_instance(pf, monitored.count_array, update_profile, out);
+}
+
+//Detection stage: the monitored instances are detected on a pool of monitor_jobs threads (default 1: one after another, on
+//this thread). Every job has its own engine, label map and metrics, since engines running at the same time cannot share timers:
+//the metrics of instance i are added to m with the prefix "monitor<i>." (report_metrics). Every job writes its report to a
+//buffer; the reports are printed in the order of the instances as they complete, so the output does not depend on the number
+//of jobs. Each engine runs execthreads update threads besides: monitor_jobs 0 runs as many jobs as fit the cores
+//The profile is not updated, and every instance needs its own shards (no edge list twice)
+void detect_instances(profile& pf, const std::string * filenames, const int * nshards, int ninstances, int niters, bool scheduler, metrics& m) {
+    int njobs = get_option_int("monitor_jobs", 1);
+    if (njobs <= 0)
+        njobs = std::max(1, omp_get_num_procs() / std::max(1, get_option_int("execthreads", omp_get_max_threads())));
+    njobs = std::min(njobs, ninstances);
+    if (njobs <= 1) {
+        for (int i = 0; i < ninstances; i++)
+            detect_instance(pf, filenames[i], nshards[i], niters, scheduler, m, false);
+        return;
     }
-    std::cout << std::endl;
     
-    //Detection stage: Now use the kernelmap from the learning stage to get the count arrays of the monitoring instances
-    for (int i = 0; i < num_monitor; i++) {
-        VertexRelabelDetection program2;
-        graphchi_engine<VertexDataType, EdgeDataType> engine(filenames[num_graphs-num_monitor+i], nshards_arr[num_graphs-num_monitor+i], scheduler, m);
-        engine.run(program2, niters);
-        
-        monitored.count_array = km->generate_count_array(monitored.label_map);
-        
-        std::vector<double> monitor_distances;
-        //calculate distance between the monitored count array and the centroid
-        for (int i = 0 ; i < number_of_clusters; i++) {
-            double monitor_distance = pf.calculate_distance(KULLBACKLEIBLER, profile_centroids[i], monitored.count_array);
-            monitor_distances.push_back(monitor_distance);
-        }
-        
-        //debug only:
-        std::cout << "Distances of monitored instance: ";
-        for (size_t i = 0; i < monitor_distances.size(); i++) {
-            std::cout << monitor_distances[i] << " ";
-        }
-        std::cout << std::endl;
-        
-        //test if the monitored program belonged to any of the cluster (i.e., within the radius)
-        bool need_recluster = true;
-        for (size_t i = 0; i < monitor_distances.size(); i++) {
-            if (monitor_distances[i] <= profile_distances[i]) {
-                need_recluster = false;
+    std::vector<std::string> reports(ninstances);
+    std::vector<bool> done(ninstances, false);
+    std::mutex lock;
+    std::condition_variable finished;
+    std::atomic<int> next(0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < njobs; t++) {
+        workers.push_back(std::thread([&]() {
+            for (int i = next++; i < ninstances; i = next++) {
+                std::ostringstream report;
+                metrics job_metrics("detection");
+                detect_instance(pf, filenames[i], nshards[i], niters, scheduler, job_metrics, false, report);
+                m.add_entries(job_metrics, "monitor" + std::to_string(i) + ".");
+                std::lock_guard<std::mutex> guard(lock);
+                reports[i] = report.str();
+                done[i] = true;
+                finished.notify_one();
             }
-        }
-        
-        if (!need_recluster)
-            std::cout << "This monitored instance is normal..." << std::endl;
-        else {
-            std::cout << "This monitored instance is outside the radius of any cluster... Recluster now..." << std::endl;
-            std::vector<std::vector<int>> total_count_arrays = pf.get_count_arrays();
-            total_count_arrays.push_back(monitored.count_array);
-            std::cout << "# of arrays in total_count_arrays: " << total_count_arrays.size() << std::endl;
-            std::vector<std::vector<int>> total_centroids = pf.get_centroids();
-            total_centroids.push_back(monitored.count_array);
-            std::cout << "# of arrays in total_centroids: " << total_centroids.size() << std::endl;
-            
-            std::pair<std::vector<std::vector<int>>, std::vector<std::vector<double>>> cluster_monitor_results = kmeans_monitor(total_centroids.size(), total_count_arrays, total_centroids);
-            std::vector<std::vector<int>> cluster_monitor = cluster_monitor_results.first;
-            
-            //for debugging: print out elements in a cluster
-            for (std::vector<std::vector<int>>::iterator it = cluster_monitor.begin(); it != cluster_monitor.end(); it++) {
-                std::cout << "ReCluster (Monitoring): ";
-                for (std::vector<int>::iterator itr2 = it->begin(); itr2 != it->end(); itr2++) {
-                    std::cout << *itr2 << " ";
-                }
-                std::cout << std::endl;
+        }));
+    }
+    for (int i = 0; i < ninstances; i++) {
+        std::unique_lock<std::mutex> guard(lock);
+        while (!done[i])
+            finished.wait(guard);
+        std::cout << reports[i] << std::flush;
+        std::string().swap(reports[i]);
+    }
+    for (size_t t = 0; t < workers.size(); t++)
+        workers[t].join();
+}
+
+
+
+//Online mode: the profile and the kernelmap stay resident and edge lists are scored one at a time as they arrive, from either
+//watch <dir>: the directory is polled every poll_ms milliseconds for new files whose name ends in watch_suffix (default .txt);
+//             GraphChi writes the shards of an edge list next to it, the suffix keeps them from being picked up as new edge lists.
+//             Move complete files into the directory (a partially written file would be scored as it is)
+//pipe <path>: one edge list path per line, from a named pipe (reopened when the writer closes it) or "-" for stdin
+//Stops after max_instances instances (default: never, or at the end of stdin)
+//The profile is only updated when a recluster (kmeans_monitor) finds an instance normal
+void run_online(profile& pf, int niters, bool scheduler, metrics& m) {
+    std::string watch = get_option_string("watch", "");
+    std::string pipe = get_option_string("pipe", "");
+    std::string suffix = get_option_string("watch_suffix", ".txt");
+    int poll_ms = get_option_int("poll_ms", 1000);
+    int max_instances = get_option_int("max_instances", -1);
+    
+    std::set<std::string> seen;
+    std::ifstream fifo;
+    int scored = 0;
+    while (max_instances < 0 || scored < max_instances) {
+        //next edge list to score
+        std::string filename;
+        if (watch != "") {
+            DIR * dir = opendir(watch.c_str());
+            if (dir == NULL)
+                logstream(LOG_FATAL) << "Could not open watched directory " << watch << std::endl;
+            assert(dir != NULL);
+            std::vector<std::string> arrived;
+            struct dirent * entry;
+            while ((entry = readdir(dir)) != NULL) {
+                std::string name = entry->d_name;
+                if (name.size() > suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0
+                    && seen.count(name) == 0)
+                    arrived.push_back(name);
             }
-            
-            bool bad_instance = false;
-            for (size_t j = 0; j < cluster_monitor.size(); j++) {
-                if (cluster_monitor[j].size() == 1 && cluster_monitor[j][0] == (int)pf.get_count_arrays().size()) {
-                    std::cout << "This monitored instance is abnormal!" << std::endl;
-                    bad_instance = true;
+            closedir(dir);
+            if (arrived.empty()) {
+                usleep(poll_ms * 1000);
+                continue;
+            }
+            std::sort(arrived.begin(), arrived.end());
+            seen.insert(arrived[0]);
+            filename = watch + "/" + arrived[0];
+        } else {
+            bool read = false;
+            if (pipe == "-") {
+                read = (bool)std::getline(std::cin, filename);
+                if (!read)
+                    break;
+            } else {
+                if (!fifo.is_open())
+                    fifo.open(pipe.c_str());
+                read = (bool)std::getline(fifo, filename);
+                if (!read) {
+                    fifo.close();
+                    fifo.clear();
+                    continue;
                 }
             }
-            if (!bad_instance) std::cout << "This monitored instance is actually normal..." << std::endl;
-            
+            if (filename == "")
+                continue;
         }
         
-        monitored.count_array.clear();
-        monitored.label_map.clear();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        int nshards = convert_graph_if_notexists(filename, get_option_string("nshards", "auto"));
+        bool normal = detect_instance(pf, filename, nshards, niters, scheduler, m, true);
+        double latency = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Online: " << filename << " is " << (normal ? "normal" : "abnormal") << " (" << latency << " s)" << std::endl;
+        scored++;
+    }
+}
+
+int main(int argc, const char ** argv) {
+    /* GraphChi initialization will read the command line
+     arguments and the configuration file. */
+    graphchi_init(argc, argv);
+    
+    /* Metrics object for keeping track of performance counters
+     and other information. Currently required. */
+    metrics m("Detection Framework");
+    
+    //the window of streaming mode needs the deletions of the dynamic engine, which would slow down every engine here
+    if (get_option_string("stream", "") != "")
+        logstream(LOG_FATAL) << "Streaming mode is bin/myapps/streaming (with load_model of a model saved here)" << std::endl;
+    
+    /* Basic arguments for application */
+    //First, we must know how many graphs will be used for computation:
+    int num_graphs = get_option_int("ngraphs");
+    //This tells us how many instances are only part of the monitoring, not the learning
+    //Therefore the learning graphs would be (num_graphs - num_monitor)
+    int num_monitor = get_option_int("nmonitor");
+    //We then use the for loop to get all the filenames, and store them in an array
+    std::string filenames[num_graphs] = {};
+    for (int i = 0; i < num_graphs; i++) {
+        std::string f_string;
+        std::stringstream f_out;
+        f_out << i;
+        f_string = f_out.str();
+        const std::string name_of_file = "file" + f_string;
+        filenames[i] = get_option_string(name_of_file.c_str());
     }
     
+    //converge 1 relabels every instance for the rounds the learning instances take to stop refining, with niters as a cap
+    //(learn_profile); a model keeps them
+    int niters           = get_option_int("niters", 4); // Number of iterations, or default of 4
+    bool scheduler       = relabel_run_sample().enabled();//sampled relabeling only runs the neighborhoods of its roots
+    bool converge        = get_option_int("converge", 0) != 0 && !scheduler;//sampled relabeling always runs every round
+    
+    /* Detect the number of shards or preprocess an input to create them */
+    //for each file, detect shards or preprocess an input to create them
+    //put results in an array
+    //with a saved model (load_model) the learning instances are not used, and in batch mode their union is preprocessed instead,
+    //so then only the monitored ones are preprocessed
+    bool learning_shards = get_option_string("load_model", "") == "" && get_option_int("batch", 0) <= 0;
+    int nshards_arr[num_graphs] = {};
+    for (int i = (learning_shards ? 0 : num_graphs - num_monitor); i < num_graphs; i++) {
+        nshards_arr[i] = convert_graph_if_notexists(filenames[i], get_option_string("nshards", "auto"));
+    }
+
+    /* Run */
+    //create the single instance of KernelMap
+    KernelMaps* km = KernelMaps::get_instance();
+    km->resetMaps();
+    km->set_relabel_variant(parse_relabel_variant(get_option_string("relabel", "edge_aware"), get_option_int("take_edge_label", 0) != 0));
+    
+    //create a tentative profile
+    profile pf;
+    
+    pf.reset_arrays();
+    pf.set_metric(parse_metric(get_option_string("metric", "kl")));
+    
+    //Learning stage: relabel the learning instances, or load the kernelmap and the profile of an earlier run
+    std::string model_path = get_option_string("load_model", "");
+    if (model_path != "") {
+        int model_niters;
+        bool model_converge;
+        int metric = pf.get_metric();
+        int variant = km->get_relabel_variant();
+        bool loaded = load_model(model_path, km, pf, model_niters, model_converge);
+        if (!loaded)
+            logstream(LOG_FATAL) << "Could not load model " << model_path << std::endl;
+        assert(loaded);
+        if (model_niters != niters)
+            logstream(LOG_WARNING) << "The model was learned with niters " << model_niters << ", using that instead of " << niters << std::endl;
+        niters = model_niters;
+        if (model_converge != converge)
+            logstream(LOG_WARNING) << "The model was learned with converge " << model_converge << ": every instance is relabeled for its "
+                << (niters + 1) / 2 << " rounds" << std::endl;
+        if (km->get_relabel_variant() != variant)
+            logstream(LOG_WARNING) << "The model was learned with relabel variant " << km->get_relabel_variant() << ", using that instead of " << variant << std::endl;
+        if (pf.get_metric() != metric)
+            logstream(LOG_WARNING) << "The model was learned with metric " << pf.get_metric() << ", using that instead of " << metric << std::endl;
+    } else {
+        learn_profile(pf, filenames, nshards_arr, num_graphs - num_monitor, niters, converge, scheduler, m);
+        std::string save_path = get_option_string("save_model", "");
+        if (save_path != "" && !save_model(save_path, km, pf, niters, converge))
+            logstream(LOG_ERROR) << "Could not save model " << save_path << std::endl;
+    }
+    
+    const std::vector<double>& profile_distances = pf.get_distances();
+    std::cout << "Max distance of each cluster: ";
+    for (std::vector<double>::const_iterator it = profile_distances.begin(); it != profile_distances.end(); it++) {
+        std::cout << *it << " ";
+    }
+    std::cout << std::endl;
+    
+    //Detection stage: Now use the kernelmap from the learning stage to get the count arrays of the monitoring instances
+    detect_instances(pf, filenames + num_graphs - num_monitor, nshards_arr + num_graphs - num_monitor, num_monitor, niters, scheduler, m);
+    
+    //Online mode: keep scoring instances as they arrive, with the profile and the kernelmap of the learning stage
+    if (get_option_string("watch", "") != "" || get_option_string("pipe", "") != "")
+        run_online(pf, niters, scheduler, m);
+    
     //this map the vector cluster_temps
     //if instance 0 has 3 in cluster 0 and 4 in cluster 1 the map entry will be 0 -> [<0, 3> <1, 4>]
 //    std::map<int, std::vector<std::pair<int, int>>> instance_temp;
@@ -558,6 +745,8 @@ int main(int argc, const char ** argv) {
 */
     
     /* Report execution metrics */
-    //metrics_report(m);
+    //report_metrics 1: to the reporters of conf/graphchi.cnf (the relabel_ entries tell how many rounds the graphs need)
+    if (get_option_int("report_metrics", 0) != 0)
+        metrics_report(m);
     return 0;
 }
\ No newline at end of file
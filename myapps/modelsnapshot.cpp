@@ -0,0 +1,302 @@
+//
+//  modelsnapshot.cpp
+//  graphchi_xcode
+//
+
+#include <cstring>
+#include <cstdio>
+#include <vector>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "modelsnapshot.hpp"
+
+static uint64_t align_model_offset(uint64_t offset) {
+    return (offset + 7) & ~(uint64_t)7;
+}
+
+//append the arrays to the table of arrays and their entries to index and value
+static void append_model_arrays(const std::vector<sparse_count_array>& arrays, std::vector<model_array>& table,
+                                std::vector<int32_t>& index, std::vector<int32_t>& value) {
+    for (size_t i = 0; i < arrays.size(); i++) {
+        model_array a;
+        a.dim = arrays[i].dim;
+        a.nnz = arrays[i].nnz();
+        a.offset = index.size();
+        table.push_back(a);
+        index.insert(index.end(), arrays[i].index.begin(), arrays[i].index.end());
+        value.insert(value.end(), arrays[i].value.begin(), arrays[i].value.end());
+    }
+}
+
+bool save_model(const std::string& path, KernelMaps* km, const profile& pf, int niters, bool converge) {
+    std::vector<model_tuple> tuples;
+    std::vector<int32_t> tuple_labels;
+    km->for_each_relabel([&](int kind, const int * labels, size_t len, int id) {
+        model_tuple t;
+        t.kind = kind;
+        t.len = (int32_t)len;
+        t.id = id;
+        t.reserved = 0;
+        t.offset = tuple_labels.size();
+        tuples.push_back(t);
+        tuple_labels.insert(tuple_labels.end(), labels, labels + len);
+    });
+
+    std::vector<model_array> arrays;
+    std::vector<int32_t> index;
+    std::vector<int32_t> value;
+    append_model_arrays(pf.get_count_arrays(), arrays, index, value);
+    append_model_arrays(pf.get_centroids(), arrays, index, value);
+    const std::vector<double>& radii = pf.get_distances();
+    assert(radii.size() == pf.get_centroids().size());
+
+    model_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MODEL_MAGIC, sizeof(header.magic));
+    header.byte_order = MODEL_BYTE_ORDER;
+    header.version = MODEL_VERSION;
+    header.niters = niters;
+    header.counter = km->get_counter();
+    header.metric = pf.get_metric();
+    header.relabel_variant = km->get_relabel_variant();
+    header.rounds = (niters + 1) / 2;
+    header.converge = converge ? 1 : 0;
+    header.ntuples = tuples.size();
+    header.tuple_labels = tuple_labels.size();
+    header.narrays = pf.get_count_arrays().size();
+    header.ncentroids = pf.get_centroids().size();
+    header.array_entries = index.size();
+    header.mean = pf.get_mean();
+    header.std = pf.get_std();
+    header.tuples_offset = align_model_offset(sizeof(model_header));
+    header.tuple_labels_offset = align_model_offset(header.tuples_offset + tuples.size() * sizeof(model_tuple));
+    header.arrays_offset = align_model_offset(header.tuple_labels_offset + tuple_labels.size() * sizeof(int32_t));
+    header.array_entries_offset = align_model_offset(header.arrays_offset + arrays.size() * sizeof(model_array));
+    header.radii_offset = align_model_offset(header.array_entries_offset + 2 * index.size() * sizeof(int32_t));
+    header.file_size = header.radii_offset + radii.size() * sizeof(double);
+
+    std::vector<char> buffer(header.file_size, 0);
+    memcpy(&buffer[0], &header, sizeof(header));
+    if (!tuples.empty())
+        memcpy(&buffer[header.tuples_offset], tuples.data(), tuples.size() * sizeof(model_tuple));
+    if (!tuple_labels.empty())
+        memcpy(&buffer[header.tuple_labels_offset], tuple_labels.data(), tuple_labels.size() * sizeof(int32_t));
+    if (!arrays.empty())
+        memcpy(&buffer[header.arrays_offset], arrays.data(), arrays.size() * sizeof(model_array));
+    if (!index.empty()) {
+        memcpy(&buffer[header.array_entries_offset], index.data(), index.size() * sizeof(int32_t));
+        memcpy(&buffer[header.array_entries_offset + index.size() * sizeof(int32_t)], value.data(), value.size() * sizeof(int32_t));
+    }
+    if (!radii.empty())
+        memcpy(&buffer[header.radii_offset], radii.data(), radii.size() * sizeof(double));
+
+    std::string tmp_path = path + ".tmp";
+    FILE * f = fopen(tmp_path.c_str(), "wb");
+    if (f == NULL) {
+        logstream(LOG_ERROR) << "Could not open " << tmp_path << " to save the model: " << strerror(errno) << std::endl;
+        return false;
+    }
+    bool written = fwrite(buffer.data(), 1, buffer.size(), f) == buffer.size();
+    written = (fclose(f) == 0) && written;
+    if (!written || rename(tmp_path.c_str(), path.c_str()) != 0) {
+        logstream(LOG_ERROR) << "Could not save the model to " << path << ": " << strerror(errno) << std::endl;
+        remove(tmp_path.c_str());
+        return false;
+    }
+    //read the file back the way load_model does
+    if (!check_model(path, km, pf, niters, converge))
+        return false;
+    logstream(LOG_INFO) << "Saved model to " << path << ": " << header.ntuples << " relabel tuples, " << header.narrays
+                        << " count arrays, " << header.ncentroids << " clusters (" << header.file_size << " bytes)" << std::endl;
+    return true;
+}
+
+//check that a section of count elements of the given size at offset lies in the file
+static bool model_section_fits(uint64_t offset, uint64_t count, uint64_t size, uint64_t file_size) {
+    return offset % 8 == 0 && offset <= file_size && count <= (file_size - offset) / size;
+}
+
+//check the labels of a relabel tuple: the tuples of the tables the relabelers build have one type, an own label and its
+//neighbors (which can be mixed with edge types), or an incoming and an outgoing label
+static bool model_tuple_fits(const model_tuple& tuple, const int32_t * labels, int32_t counter) {
+    if (tuple.kind == RELABEL_TYPE)
+        return tuple.len == 1;
+    if (tuple.kind == RELABEL_NEIGHBOR)
+        return tuple.len >= 1 && labels[0] >= 0 && labels[0] < counter;
+    if (tuple.kind == RELABEL_COMBINED)
+        return tuple.len == 2 && labels[0] >= 0 && labels[0] < counter && labels[1] >= 0 && labels[1] < counter;
+    return false;
+}
+
+//check the index of a count array: increasing labels within its dim
+static bool model_array_fits(const model_array& array, const int32_t * index) {
+    for (int32_t i = 0; i < array.nnz; i++)
+        if (index[i] < 0 || index[i] >= array.dim || (i > 0 && index[i] <= index[i - 1]))
+            return false;
+    return true;
+}
+
+//a model file mapped read only, with its sections
+struct mapped_model {
+    void * mapped;
+    size_t file_size;
+    const model_header * header;
+    const model_tuple * tuples;
+    const int32_t * tuple_labels;
+    const model_array * arrays;
+    const int32_t * index;
+    const int32_t * value;
+    const double * radii;
+};
+
+//map the model in path and check that every section, tuple and array of it is in range
+//returns false (and logs why) if path is not a model this version can read
+static bool map_model(const std::string& path, mapped_model& model) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        logstream(LOG_ERROR) << "Could not open model " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(model_header)) {
+        logstream(LOG_ERROR) << path << " is not a model" << std::endl;
+        close(fd);
+        return false;
+    }
+    size_t file_size = st.st_size;
+    void * mapped = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        logstream(LOG_ERROR) << "Could not map model " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    const char * data = (const char *)mapped;
+    const model_header& header = *(const model_header *)data;
+
+    bool valid = memcmp(header.magic, MODEL_MAGIC, sizeof(header.magic)) == 0 && header.byte_order == MODEL_BYTE_ORDER;
+    if (valid && header.version != MODEL_VERSION) {
+        logstream(LOG_ERROR) << "Model " << path << " has version " << header.version << ", this build reads version " << MODEL_VERSION << std::endl;
+        munmap(mapped, file_size);
+        return false;
+    }
+    valid = valid && header.file_size == file_size && header.counter >= 0
+        && model_section_fits(header.tuples_offset, header.ntuples, sizeof(model_tuple), file_size)
+        && model_section_fits(header.tuple_labels_offset, header.tuple_labels, sizeof(int32_t), file_size)
+        && model_section_fits(header.arrays_offset, header.narrays + header.ncentroids, sizeof(model_array), file_size)
+        && model_section_fits(header.array_entries_offset, 2 * header.array_entries, sizeof(int32_t), file_size)
+        && model_section_fits(header.radii_offset, header.ncentroids, sizeof(double), file_size);
+    const model_tuple * tuples = (const model_tuple *)(data + header.tuples_offset);
+    const int32_t * tuple_labels = (const int32_t *)(data + header.tuple_labels_offset);
+    const model_array * arrays = (const model_array *)(data + header.arrays_offset);
+    const int32_t * index = (const int32_t *)(data + header.array_entries_offset);
+    //the tuples are saved in id order, so ids are unique
+    for (uint64_t i = 0; valid && i < header.ntuples; i++)
+        valid = tuples[i].len >= 0 && tuples[i].offset <= header.tuple_labels && (uint64_t)tuples[i].len <= header.tuple_labels - tuples[i].offset
+            && tuples[i].id >= 0 && tuples[i].id < header.counter && (i == 0 || tuples[i].id > tuples[i - 1].id)
+            && model_tuple_fits(tuples[i], tuple_labels + tuples[i].offset, header.counter);
+    valid = valid && header.niters >= 0 && header.rounds == (header.niters + 1) / 2 && (header.converge == 0 || header.converge == 1)
+        && header.metric >= 0 && header.metric <= 2
+        && header.relabel_variant >= RELABEL_EDGE_AWARE && header.relabel_variant <= RELABEL_DIRECTIONLESS_EDGE_LABELS;
+    for (uint64_t i = 0; valid && i < header.narrays + header.ncentroids; i++)
+        valid = arrays[i].dim >= 0 && arrays[i].nnz >= 0 && arrays[i].offset <= header.array_entries
+            && (uint64_t)arrays[i].nnz <= header.array_entries - arrays[i].offset && model_array_fits(arrays[i], index + arrays[i].offset);
+    if (!valid) {
+        logstream(LOG_ERROR) << path << " is not a model or it is corrupt" << std::endl;
+        munmap(mapped, file_size);
+        return false;
+    }
+
+    model.mapped = mapped;
+    model.file_size = file_size;
+    model.header = &header;
+    model.tuples = tuples;
+    model.tuple_labels = tuple_labels;
+    model.arrays = arrays;
+    model.index = index;
+    model.value = index + header.array_entries;
+    model.radii = (const double *)(data + header.radii_offset);
+    return true;
+}
+
+static void unmap_model(mapped_model& model) {
+    munmap(model.mapped, model.file_size);
+}
+
+//count array i of a mapped model (the count arrays of the profile, then its centroids)
+static sparse_count_array model_count_array(const mapped_model& model, uint64_t i) {
+    const model_array& a = model.arrays[i];
+    sparse_count_array array(a.dim);
+    array.index.assign(model.index + a.offset, model.index + a.offset + a.nnz);
+    array.value.assign(model.value + a.offset, model.value + a.offset + a.nnz);
+    return array;
+}
+
+bool load_model(const std::string& path, KernelMaps* km, profile& pf, int& niters, bool& converge) {
+    mapped_model model;
+    if (!map_model(path, model))
+        return false;
+    const model_header& header = *model.header;
+
+    km->resetMaps();
+    for (uint64_t i = 0; i < header.ntuples; i++)
+        km->restore_relabel(model.tuples[i].kind, model.tuple_labels + model.tuples[i].offset, model.tuples[i].len, model.tuples[i].id);
+    km->set_counter(header.counter);
+    km->set_relabel_variant(header.relabel_variant);
+
+    pf.reset_arrays();
+    for (uint64_t i = 0; i < header.narrays + header.ncentroids; i++) {
+        if (i < header.narrays)
+            pf.add_array(model_count_array(model, i));
+        else
+            pf.add_centroid(model_count_array(model, i));
+    }
+    for (uint64_t i = 0; i < header.ncentroids; i++)
+        pf.add_max_distance_from_centroid(model.radii[i]);
+    pf.set_mean(header.mean);
+    pf.set_std(header.std);
+    pf.set_metric(header.metric);
+    niters = header.niters;
+    converge = header.converge != 0;
+
+    logstream(LOG_INFO) << "Loaded model " << path << ": " << header.ntuples << " relabel tuples, " << header.narrays
+                        << " count arrays, " << header.ncentroids << " clusters" << std::endl;
+    unmap_model(model);
+    return true;
+}
+
+bool check_model(const std::string& path, KernelMaps* km, const profile& pf, int niters, bool converge) {
+    mapped_model model;
+    if (!map_model(path, model))
+        return false;
+    const model_header& header = *model.header;
+    const std::vector<sparse_count_array>& count_arrays = pf.get_count_arrays();
+    const std::vector<sparse_count_array>& centroids = pf.get_centroids();
+
+    bool same = header.niters == niters && (header.converge != 0) == converge && header.counter == km->get_counter() && header.metric == pf.get_metric()
+        && header.relabel_variant == km->get_relabel_variant() && header.mean == pf.get_mean() && header.std == pf.get_std()
+        && header.narrays == count_arrays.size() && header.ncentroids == centroids.size();
+    uint64_t ntuples = 0;
+    km->for_each_relabel([&](int kind, const int * labels, size_t len, int id) {
+        if (!same || ntuples >= header.ntuples) {
+            same = false;
+            return;
+        }
+        const model_tuple& t = model.tuples[ntuples++];
+        same = t.kind == kind && (size_t)t.len == len && t.id == id && std::equal(labels, labels + len, model.tuple_labels + t.offset);
+    });
+    same = same && ntuples == header.ntuples;
+    for (uint64_t i = 0; same && i < header.narrays + header.ncentroids; i++) {
+        const sparse_count_array& array = i < header.narrays ? count_arrays[i] : centroids[i - header.narrays];
+        sparse_count_array saved = model_count_array(model, i);
+        same = saved.dim == array.dim && saved.index == array.index && saved.value == array.value;
+    }
+    for (uint64_t i = 0; same && i < header.ncentroids; i++)
+        same = model.radii[i] == pf.get_distances()[i];
+    unmap_model(model);
+    if (!same)
+        logstream(LOG_ERROR) << "Model " << path << " does not hold the relabel table and profile it was saved from" << std::endl;
+    return same;
+}
@@ -0,0 +1,83 @@
+//
+//  modelsnapshot.hpp
+//  graphchi_xcode
+//
+
+#ifndef modelsnapshot_hpp
+#define modelsnapshot_hpp
+
+#include <stdint.h>
+#include <string>
+#include "kernelmaps.hpp"
+#include "profile.hpp"
+
+//Binary snapshot of a learned model: the relabel table of the kernelmap and the profile, so that detection can start
+//without relearning. The file is mapped read only on load and the tables are rebuilt from it without any parsing
+//Layout (native byte order, every section starts at a multiple of 8 bytes):
+//  model_header
+//  model_tuple[ntuples]                    the relabel table, in id order
+//  int32[tuple_labels]                     the labels of all tuples back to back
+//  model_array[narrays + ncentroids]       the count arrays of the profile, then its centroids
+//  int32[array_entries], int32[array_entries]  index of all arrays back to back, then value of all arrays
+//  double[ncentroids]                      the radius (max distance from centroid) of each cluster
+//A reader rejects a file whose magic, byte order or version it does not know, or whose sections, tuples (kind, length, id
+//and own labels) or arrays (increasing labels within dim) are out of range. The version changes with any change of layout
+#define MODEL_MAGIC "FRAPMODL"
+#define MODEL_VERSION 3
+#define MODEL_BYTE_ORDER 0x01020304
+
+struct model_header {
+    char magic[8];
+    uint32_t byte_order;
+    uint32_t version;
+    int32_t niters;//the model only fits graphs relabeled with as many iterations
+    int32_t counter;//size of the relabel id space, dim of the count arrays
+    int32_t metric;//the clusters and radii are in this metric (calculate_distance2 method)
+    int32_t relabel_variant;//the relabel table is built with this relabel_variant
+    int32_t rounds;//relabel rounds of every graph ((niters + 1) / 2); with converge they are the rounds the learning graphs took to stop refining
+    int32_t converge;//1 if the rounds were found by converge (learn_profile in main.cpp)
+    uint64_t ntuples;
+    uint64_t tuple_labels;
+    uint64_t narrays;
+    uint64_t ncentroids;
+    uint64_t array_entries;
+    double mean;
+    double std;
+    uint64_t tuples_offset;
+    uint64_t tuple_labels_offset;
+    uint64_t arrays_offset;
+    uint64_t array_entries_offset;
+    uint64_t radii_offset;
+    uint64_t file_size;
+};
+
+struct model_tuple {
+    int32_t kind;
+    int32_t len;
+    int32_t id;
+    int32_t reserved;
+    uint64_t offset;//in labels, from tuple_labels_offset
+};
+
+struct model_array {
+    int32_t dim;
+    int32_t nnz;
+    uint64_t offset;//in entries, from array_entries_offset
+};
+
+//write the relabel table of the kernelmap and the profile to path (through a temporary file, so a reader never sees half a model)
+//returns false if the file could not be written or does not read back (check_model)
+bool save_model(const std::string& path, KernelMaps* km, const profile& pf, int niters, bool converge);
+
+//replace the relabel table of the kernelmap and the profile by the ones saved in path, and set niters and converge to the
+//iterations the model was learned with and to whether converge found them. Returns false (and leaves km and pf alone) if path is
+//not a model this version can read
+bool load_model(const std::string& path, KernelMaps* km, profile& pf, int& niters, bool& converge);
+
+//check that the model in path holds exactly the relabel table of the kernelmap and the profile (and niters and converge), as
+//load_model would read them back. save_model checks every file it writes this way. Returns false if path is not a model or it
+//holds anything else
+bool check_model(const std::string& path, KernelMaps* km, const profile& pf, int niters, bool converge);
+
+#include "modelsnapshot.cpp"
+#endif /* modelsnapshot_hpp */
@@ -11,26 +11,36 @@
 
 #include <vector>
 #include <map>
+#include <utility>
+#include "countarray.hpp"
 
 class profile {
 public:
     
-    double get_mean() {
+    double get_mean() const {
         return this->mean;
     }
     
-    double get_std() {
+    double get_std() const {
         return this->std;
     }
     
-    std::vector<std::vector<int>> get_centroids() {
+    const std::vector<sparse_count_array>& get_centroids() const {
         return this->centroids;
     }
     
-    std::vector<double> get_distances() {
+    const std::vector<double>& get_distances() const {
         return this->max_distance_from_centroids;
     }
     
+    int get_metric() const {
+        return this->metric;
+    }
+    
+    void set_metric(int metric) {
+        this->metric = metric;
+    }
+    
     void set_mean(double mean) {
         this->mean = mean;
     }
@@ -39,19 +49,27 @@ public:
         this->std = std;
     }
     
-    void add_array(std::vector<int> array) {
+    void add_array(const sparse_count_array& array) {
         this->count_arrays.push_back(array);
     }
     
-    void add_centroid(std::vector<int> centroid) {
+    void add_array(sparse_count_array&& array) {
+        this->count_arrays.push_back(std::move(array));
+    }
+    
+    void add_centroid(const sparse_count_array& centroid) {
         this->centroids.push_back(centroid);
     }
     
+    void add_centroid(sparse_count_array&& centroid) {
+        this->centroids.push_back(std::move(centroid));
+    }
+    
     void add_max_distance_from_centroid (double dis) {
         this->max_distance_from_centroids.push_back(dis);
     }
     
-    std::vector<std::vector<int>> get_count_arrays() {
+    const std::vector<sparse_count_array>& get_count_arrays() const {
         return this->count_arrays;
     }
     
@@ -65,25 +83,28 @@ public:
         this->count_arrays.clear();
     }
     
-    int calculate_two_count_arrays(int method, std::vector<int> arr1, std::vector<int> arr2);//for old simple normal distribution analysis only
+    int calculate_two_count_arrays(int method, const std::vector<int>& arr1, const std::vector<int>& arr2);//for old simple normal distribution analysis only
     
-    double calculate_distance(int method, std::vector<int> count_array1, std::vector<int> count_array2);
+    double calculate_distance(int method, const sparse_count_array& count_array1, const sparse_count_array& count_array2);
     
     void remove_array(int pos) {
-        std::vector<std::vector<int>>::iterator itr = count_arrays.begin();
+        std::vector<sparse_count_array>::iterator itr = count_arrays.begin();
         this->count_arrays.erase(itr + pos);
     }
     
 private:
     
-    double mean;
+    double mean = 0.0;
+    
+    double std = 0.0;
     
-    double std;
+    //metric (calculate_distance method) the instances are clustered and compared with
+    int metric = 0;
     
-    std::vector<std::vector<int>> count_arrays;
+    std::vector<sparse_count_array> count_arrays;
     
     //Centroids of all clusters
-    std::vector<std::vector<int>> centroids;
+    std::vector<sparse_count_array> centroids;
     
     //map that records the longest distance between a well-behaved instance and the rest of the well-behaved ones
     std::vector<double> max_distance_from_centroids;
@@ -0,0 +1,257 @@
+//
+//  provedges.cpp
+//  graphchi_xcode
+//
+
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <cassert>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "provedges.hpp"
+
+const std::vector<std::string> camflow_vertex_types = {
+    "unknown", "task", "link", "socket", "iattr", "mmaped_file", "packet", "disc_node", "disc_agent", "disc_activity",
+    "disc_entity", "file_name", "sb", "address", "sock", "shm", "msg", "fifo", "block", "char", "directory", "file",
+    "inode_unknown", "relation", "string", "xattr", "packet_content"
+};
+
+const std::vector<std::string> camflow_edge_types = {
+    "read", "write", "create", "mmap_write", "open", "version_entity", "named", "exec", "clone", "mmap_read", "mmap_exec",
+    "perm_read", "perm_exec", "unknown", "change", "bind", "connect", "listen", "accept", "link", "search", "send",
+    "receive", "perm_write", "sh_write", "mmap", "setattr", "setxattr", "removexattr", "named_process", "exec_process",
+    "version_activity", "getattr", "getxattr", "listxattr", "readlink", "sh_read", "send_packet", "receive_packet"
+};
+
+prov_edges_writer::prov_edges_writer(const std::string& path, const std::vector<std::string>& vertex_types, const std::vector<std::string>& edge_types)
+    : path(path), tmp_path(path + ".tmp") {
+    std::string vocabulary;
+    for (size_t i = 0; i < vertex_types.size(); i++)
+        vocabulary.append(vertex_types[i].c_str(), vertex_types[i].size() + 1);
+    for (size_t i = 0; i < edge_types.size(); i++)
+        vocabulary.append(edge_types[i].c_str(), edge_types[i].size() + 1);
+    memset(&this->header, 0, sizeof(this->header));
+    memcpy(this->header.magic, PROV_EDGES_MAGIC, sizeof(this->header.magic));
+    this->header.byte_order = PROV_EDGES_BYTE_ORDER;
+    this->header.version = PROV_EDGES_VERSION;
+    this->header.nvertex_types = vertex_types.size();
+    this->header.nedge_types = edge_types.size();
+    this->header.vocabulary_size = vocabulary.size();
+    this->header.edges_offset = (sizeof(prov_edges_header) + vocabulary.size() + 3) & ~(uint64_t)3;
+
+    this->file = fopen(this->tmp_path.c_str(), "wb");
+    if (this->file == NULL) {
+        logstream(LOG_ERROR) << "Could not open " << this->tmp_path << ": " << strerror(errno) << std::endl;
+        this->failed = true;
+        return;
+    }
+    //the header is written again with the number of edges on close
+    std::vector<char> head(this->header.edges_offset, 0);
+    memcpy(&head[0], &this->header, sizeof(this->header));
+    if (!vocabulary.empty())
+        memcpy(&head[sizeof(this->header)], vocabulary.data(), vocabulary.size());
+    this->failed = fwrite(head.data(), 1, head.size(), this->file) != head.size();
+}
+
+prov_edges_writer::~prov_edges_writer() {
+    if (this->file != NULL) {
+        fclose(this->file);
+        remove(this->tmp_path.c_str());
+    }
+}
+
+void prov_edges_writer::flush() {
+    if (this->file != NULL && !this->failed && !this->buffer.empty())
+        this->failed = fwrite(this->buffer.data(), sizeof(prov_edge), this->buffer.size(), this->file) != this->buffer.size();
+    this->nedges += this->buffer.size();
+    this->buffer.clear();
+}
+
+bool prov_edges_writer::close() {
+    flush();
+    if (this->file == NULL)
+        return false;
+    this->header.nedges = this->nedges;
+    bool written = !this->failed && fseek(this->file, 0, SEEK_SET) == 0
+        && fwrite(&this->header, sizeof(this->header), 1, this->file) == 1;
+    written = (fclose(this->file) == 0) && written;
+    this->file = NULL;
+    if (!written || rename(this->tmp_path.c_str(), this->path.c_str()) != 0) {
+        logstream(LOG_ERROR) << "Could not write " << this->path << ": " << strerror(errno) << std::endl;
+        remove(this->tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+prov_edges_file::~prov_edges_file() {
+    if (this->mapped != NULL)
+        munmap(this->mapped, this->mapped_size);
+}
+
+//split count NUL terminated names off the front of a vocabulary of the given size; returns false if it runs out
+static bool read_vocabulary(const char *& names, const char * end, uint32_t count, std::vector<std::string>& out) {
+    for (uint32_t i = 0; i < count; i++) {
+        const char * nul = (const char *)memchr(names, '\0', end - names);
+        if (nul == NULL)
+            return false;
+        out.push_back(std::string(names, nul));
+        names = nul + 1;
+    }
+    return true;
+}
+
+bool prov_edges_file::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        logstream(LOG_ERROR) << "Could not open " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(prov_edges_header)) {
+        logstream(LOG_ERROR) << path << " is not a binary edge list" << std::endl;
+        close(fd);
+        return false;
+    }
+    size_t file_size = st.st_size;
+    void * mapped = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        logstream(LOG_ERROR) << "Could not map " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    madvise(mapped, file_size, MADV_SEQUENTIAL);
+    const char * data = (const char *)mapped;
+    const prov_edges_header * header = (const prov_edges_header *)data;
+
+    bool valid = memcmp(header->magic, PROV_EDGES_MAGIC, sizeof(header->magic)) == 0 && header->byte_order == PROV_EDGES_BYTE_ORDER;
+    if (valid && header->version != PROV_EDGES_VERSION) {
+        logstream(LOG_ERROR) << path << " has version " << header->version << ", this build reads version " << PROV_EDGES_VERSION << std::endl;
+        munmap(mapped, file_size);
+        return false;
+    }
+    valid = valid && header->vocabulary_size <= file_size - sizeof(prov_edges_header)
+        && header->edges_offset >= sizeof(prov_edges_header) + header->vocabulary_size && header->edges_offset % 4 == 0
+        && header->edges_offset <= file_size && header->nedges == (file_size - header->edges_offset) / sizeof(prov_edge);
+    std::vector<std::string> vertex_types;
+    std::vector<std::string> edge_types;
+    if (valid) {
+        const char * names = data + sizeof(prov_edges_header);
+        const char * end = names + header->vocabulary_size;
+        valid = read_vocabulary(names, end, header->nvertex_types, vertex_types) && read_vocabulary(names, end, header->nedge_types, edge_types);
+    }
+    if (!valid) {
+        logstream(LOG_ERROR) << path << " is not a binary edge list or it is corrupt" << std::endl;
+        munmap(mapped, file_size);
+        return false;
+    }
+
+    if (this->mapped != NULL)
+        munmap(this->mapped, this->mapped_size);
+    this->mapped = mapped;
+    this->mapped_size = file_size;
+    this->header = header;
+    this->records = (const prov_edge *)(data + header->edges_offset);
+    this->vertex_type_names.swap(vertex_types);
+    this->edge_type_names.swap(edge_types);
+    return true;
+}
+
+void sharder_edge_sink::add(const prov_edge& edge) {
+    if (edge.src == edge.dst)
+        return;
+    type_label label;
+    label.old_src = 0;
+    label.old_dst = 0;
+    label.new_src = edge.src_type;
+    label.new_dst = edge.dst_type;
+    label.edge = edge.edge_type;
+#ifdef SUPPORT_DELETIONS
+    label.time = 0;//prov_edge records carry no timestamps
+#endif
+    this->sharderobj.preprocessing_add_edge(edge.src, edge.dst, label);
+}
+
+bool is_prov_edges_file(const std::string& path) {
+    FILE * f = fopen(path.c_str(), "rb");
+    if (f == NULL)
+        return false;
+    char magic[8];
+    bool binary = fread(magic, 1, sizeof(magic), f) == sizeof(magic) && memcmp(magic, PROV_EDGES_MAGIC, sizeof(magic)) == 0;
+    fclose(f);
+    return binary;
+}
+
+//parse a decimal number followed by one of the given separators (or the end of the line if end_ok); advances s past both
+static bool parse_field(const char *& s, long& value, const char * separators, bool end_ok) {
+    char * end;
+    errno = 0;
+    value = strtol(s, &end, 10);
+    if (end == s || errno != 0)
+        return false;
+    s = end;
+    if (*s == '\0' || *s == '\n' || *s == '\r')
+        return end_ok;
+    if (strchr(separators, *s) == NULL)
+        return false;
+    while (*s != '\0' && strchr(separators, *s) != NULL)
+        s++;
+    return true;
+}
+
+bool parse_prov_edge(const char * line, prov_edge& edge) {
+    if (line[0] == '#' || line[0] == '%')
+        return false;
+    long src, dst, src_type, dst_type, edge_type, time = 0;
+    const char * s = line;
+    if (!parse_field(s, src, "\t, ", false) || !parse_field(s, dst, "\t, ", false) || !parse_field(s, src_type, ":", false)
+        || !parse_field(s, dst_type, ":", false) || !parse_field(s, edge_type, ": \t", true))
+        return false;
+    //an optional :timestamp follows the edge type; it is checked as parse checks it, and dropped (records have no time)
+    if (s[-1] == ':' && !parse_field(s, time, " \t", true))
+        return false;
+    if (src < 0 || dst < 0 || time < 0 || edge_type == DELETED_EDGE_TYPE)
+        return false;
+    edge.src = (uint32_t)src;
+    edge.dst = (uint32_t)dst;
+    edge.src_type = (int32_t)src_type;
+    edge.dst_type = (int32_t)dst_type;
+    edge.edge_type = (int32_t)edge_type;
+    return true;
+}
+
+int convert_graph_if_notexists(const std::string& filename, const std::string& nshards_string) {
+    if (!is_prov_edges_file(filename))
+        return convert_if_notexists<EdgeDataType>(filename, nshards_string);
+
+    int nshards = find_shards<EdgeDataType>(filename, nshards_string);
+    if (nshards > 0 && check_origfile_modification_earlier<EdgeDataType>(filename, nshards)) {
+        logstream(LOG_INFO) << "Found preprocessed files for " << filename << ", num shards=" << nshards << std::endl;
+        return nshards;
+    }
+    prov_edges_file edges;
+    bool opened = edges.open(filename);
+    if (!opened)
+        logstream(LOG_FATAL) << "Could not read binary edge list " << filename << std::endl;
+    assert(opened);
+    sharder<EdgeDataType> sharderobj(filename);
+    sharderobj.start_preprocessing();
+    sharder_edge_sink sink(sharderobj);
+    const prov_edge * records = edges.edges();
+    for (uint64_t i = 0; i < edges.size(); i++)
+        sink.add(records[i]);
+    sharderobj.end_preprocessing();
+    nshards = sharderobj.execute_sharding(nshards_string);
+    logstream(LOG_INFO) << "Sharded binary edge list " << filename << " (" << edges.size() << " edges) into " << nshards << " shards" << std::endl;
+    return nshards;
+}
+
+int reshard_graph(const std::string& filename, const std::string& nshards_string) {
+    int nshards = find_shards<EdgeDataType>(filename, nshards_string);
+    if (nshards > 0)
+        delete_shards<EdgeDataType>(filename, nshards);
+    return convert_graph_if_notexists(filename, nshards_string);
+}
@@ -0,0 +1,178 @@
+//
+//  provedges.hpp
+//  graphchi_xcode
+//
+
+#ifndef provedges_hpp
+#define provedges_hpp
+
+#include <stdint.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "graphchi_basic_includes.hpp"
+#include "global.h"
+
+using namespace graphchi;
+
+//Binary provenance edge list: the edges of an edge list "src dst src_type:dst_type:edge_type" as fixed size records,
+//so that it is sharded straight from a mapping of the file, without parsing a line per edge
+//Records carry no timestamp: the edges of a binary edge list have time 0, so the window of streaming.cpp needs a text edge list
+//Layout (native byte order):
+//  prov_edges_header
+//  vocabulary: the names of the vertex types, then the names of the edge types, each one NUL terminated, in id order
+//  prov_edge[nedges], from edges_offset (a multiple of 4)
+//A reader rejects a file whose magic, byte order or version it does not know
+#define PROV_EDGES_MAGIC "FRAPEDGE"
+#define PROV_EDGES_VERSION 1
+#define PROV_EDGES_BYTE_ORDER 0x01020304
+
+struct prov_edges_header {
+    char magic[8];
+    uint32_t byte_order;
+    uint32_t version;
+    uint64_t nedges;
+    uint32_t nvertex_types;
+    uint32_t nedge_types;
+    uint64_t vocabulary_size;//in bytes
+    uint64_t edges_offset;
+};
+
+struct prov_edge {
+    uint32_t src;
+    uint32_t dst;
+    int32_t src_type;
+    int32_t dst_type;
+    int32_t edge_type;
+};
+
+static_assert(sizeof(prov_edge) == 20, "prov_edge records are 20 bytes");
+
+//the vertex and edge types of camflow, in id order (as the json parser numbers them)
+extern const std::vector<std::string> camflow_vertex_types;
+extern const std::vector<std::string> camflow_edge_types;
+
+//Receives the edges of a provenance graph as they are converted
+class prov_edge_sink {
+public:
+
+    virtual ~prov_edge_sink() {}
+
+    virtual void add(const prov_edge& edge) = 0;
+};
+
+//Adds the edges to a sharder, as type_label edges (self-edges are ignored, as convert_edgelist does)
+class sharder_edge_sink : public prov_edge_sink {
+public:
+
+    sharder_edge_sink(sharder<EdgeDataType>& sharderobj) : sharderobj(sharderobj) {}
+
+    void add(const prov_edge& edge);
+
+private:
+
+    sharder<EdgeDataType>& sharderobj;
+};
+
+//Writes a binary edge list through a temporary file, so that a reader never sees half of one
+class prov_edges_writer : public prov_edge_sink {
+public:
+
+    prov_edges_writer(const std::string& path, const std::vector<std::string>& vertex_types, const std::vector<std::string>& edge_types);
+
+    ~prov_edges_writer();
+
+    void add(const prov_edge& edge) {
+        this->buffer.push_back(edge);
+        if (this->buffer.size() >= 65536)
+            flush();
+    }
+
+    uint64_t size() const {
+        return this->nedges + this->buffer.size();
+    }
+
+    //write the header and move the file in place; returns false if the file could not be written
+    bool close();
+
+private:
+
+    void flush();
+
+    std::string path;
+
+    std::string tmp_path;
+
+    FILE * file;
+
+    prov_edges_header header;
+
+    std::vector<prov_edge> buffer;
+
+    uint64_t nedges = 0;
+
+    bool failed = false;
+};
+
+//A binary edge list mapped read only
+class prov_edges_file {
+public:
+
+    prov_edges_file() {}
+
+    ~prov_edges_file();
+
+    //map path; returns false (logging why) if it is not a binary edge list this version can read
+    bool open(const std::string& path);
+
+    uint64_t size() const {
+        return this->header->nedges;
+    }
+
+    const prov_edge * edges() const {
+        return this->records;
+    }
+
+    const std::vector<std::string>& vertex_types() const {
+        return this->vertex_type_names;
+    }
+
+    const std::vector<std::string>& edge_types() const {
+        return this->edge_type_names;
+    }
+
+private:
+
+    prov_edges_file(const prov_edges_file&);
+
+    prov_edges_file& operator=(const prov_edges_file&);
+
+    void * mapped = NULL;
+
+    size_t mapped_size = 0;
+
+    const prov_edges_header * header = NULL;
+
+    const prov_edge * records = NULL;
+
+    std::vector<std::string> vertex_type_names;
+
+    std::vector<std::string> edge_type_names;
+};
+
+//whether path starts with the magic of a binary edge list
+bool is_prov_edges_file(const std::string& path);
+
+//parse an edge list line "src dst src_type:dst_type:edge_type", optionally followed by ":timestamp" (checked, then dropped);
+//returns false if it is not one (comments included) or if its edge type is DELETED_EDGE_TYPE
+bool parse_prov_edge(const char * line, prov_edge& edge);
+
+//convert_if_notexists for the edge lists of the detector: a binary edge list is sharded from its mapping,
+//anything else goes through convert_if_notexists (filetype option)
+int convert_graph_if_notexists(const std::string& filename, const std::string& nshards_string);
+
+//shard the edge list again, replacing its shards: relabeling overwrites the types on the edges of the shards
+int reshard_graph(const std::string& filename, const std::string& nshards_string);
+
+#include "provedges.cpp"
+#endif /* provedges_hpp */
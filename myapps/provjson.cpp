@@ -0,0 +1,634 @@
+//
+//  provjson.cpp
+//  graphchi_xcode
+//
+
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <queue>
+#include <algorithm>
+#include <functional>
+#include <omp.h>
+#include <cerrno>
+#include <cassert>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "provjson.hpp"
+
+#define JSON_MAX_DEPTH 64
+
+//append the code point as UTF-8
+static void append_utf8(std::string& out, uint32_t c) {
+    if (c < 0x80) {
+        out += (char)c;
+    } else if (c < 0x800) {
+        out += (char)(0xC0 | (c >> 6));
+        out += (char)(0x80 | (c & 0x3F));
+    } else if (c < 0x10000) {
+        out += (char)(0xE0 | (c >> 12));
+        out += (char)(0x80 | ((c >> 6) & 0x3F));
+        out += (char)(0x80 | (c & 0x3F));
+    } else {
+        out += (char)(0xF0 | (c >> 18));
+        out += (char)(0x80 | ((c >> 12) & 0x3F));
+        out += (char)(0x80 | ((c >> 6) & 0x3F));
+        out += (char)(0x80 | (c & 0x3F));
+    }
+}
+
+static bool read_hex4(const char *& s, const char * end, uint32_t& c) {
+    if (end - s < 4)
+        return false;
+    c = 0;
+    for (int i = 0; i < 4; i++, s++) {
+        c <<= 4;
+        if (*s >= '0' && *s <= '9')
+            c |= *s - '0';
+        else if (*s >= 'a' && *s <= 'f')
+            c |= *s - 'a' + 10;
+        else if (*s >= 'A' && *s <= 'F')
+            c |= *s - 'A' + 10;
+        else
+            return false;
+    }
+    return true;
+}
+
+//read the string starting after its opening quote into out; s is left after the closing quote
+static bool read_json_string(const char *& s, const char * end, std::string& out) {
+    out.clear();
+    while (s < end) {
+        //copy the run of plain characters at once
+        const char * run = s;
+        while (s < end && *s != '"' && *s != '\\')
+            s++;
+        out.append(run, s - run);
+        if (s == end)
+            return false;
+        if (*s++ == '"')
+            return true;
+        if (s == end)
+            return false;
+        char e = *s++;
+        switch (e) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                uint32_t c;
+                if (!read_hex4(s, end, c))
+                    return false;
+                //a surrogate pair is one code point
+                if (c >= 0xD800 && c < 0xDC00 && end - s >= 6 && s[0] == '\\' && s[1] == 'u') {
+                    const char * low_start = s + 2;
+                    uint32_t low;
+                    if (read_hex4(low_start, end, low) && low >= 0xDC00 && low < 0xE000) {
+                        c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+                        s = low_start;
+                    }
+                }
+                append_utf8(out, c);
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    return false;
+}
+
+static void skip_json_space(const char *& s, const char * end) {
+    while (s < end && (*s == ' ' || *s == '\t' || *s == '\n' || *s == '\r'))
+        s++;
+}
+
+//a number or a literal (true, false, null), as its text
+static bool read_json_scalar(const char *& s, const char * end, std::string& out) {
+    const char * start = s;
+    while (s < end && (isalnum((unsigned char)*s) || *s == '-' || *s == '+' || *s == '.'))
+        s++;
+    if (s == start)
+        return false;
+    out.assign(start, s - start);
+    if (out == "true" || out == "false" || out == "null")
+        return true;
+    char * number_end;
+    strtod(out.c_str(), &number_end);
+    return *number_end == '\0';
+}
+
+template <typename Handler>
+bool parse_json(const char * begin, const char * end, Handler& handler) {
+    //containers are tracked on a small stack instead of recursing: true for an object
+    bool stack[JSON_MAX_DEPTH];
+    int depth = 0;
+    std::string text;
+    const char * s = begin;
+    skip_json_space(s, end);
+    if (s == end)
+        return false;
+    bool expect_value = true;
+    while (true) {
+        skip_json_space(s, end);
+        if (s == end)
+            return false;
+        if (expect_value) {
+            char c = *s++;
+            if (c == '{' || c == '[') {
+                if (depth == JSON_MAX_DEPTH)
+                    return false;
+                stack[depth++] = c == '{';
+                if (c == '{')
+                    handler.start_object();
+                else
+                    handler.start_array();
+                skip_json_space(s, end);
+                if (s < end && *s == (c == '{' ? '}' : ']')) {
+                    //empty container: its end is handled below
+                    expect_value = false;
+                    continue;
+                }
+                if (c == '{') {
+                    if (s == end || *s++ != '"' || !read_json_string(s, end, text))
+                        return false;
+                    handler.key(text);
+                    skip_json_space(s, end);
+                    if (s == end || *s++ != ':')
+                        return false;
+                }
+                continue;
+            }
+            if (c == '"') {
+                if (!read_json_string(s, end, text))
+                    return false;
+                handler.value(text, true);
+            } else {
+                s--;
+                if (!read_json_scalar(s, end, text))
+                    return false;
+                handler.value(text, false);
+            }
+            expect_value = false;
+            if (depth == 0)
+                break;
+            continue;
+        }
+        //after a value: a separator or the end of the enclosing container
+        char c = *s++;
+        bool object = stack[depth - 1];
+        if (c == (object ? '}' : ']')) {
+            depth--;
+            if (object)
+                handler.end_object();
+            else
+                handler.end_array();
+            if (depth == 0)
+                break;
+            continue;
+        }
+        if (c != ',')
+            return false;
+        if (object) {
+            skip_json_space(s, end);
+            if (s == end || *s++ != '"' || !read_json_string(s, end, text))
+                return false;
+            handler.key(text);
+            skip_json_space(s, end);
+            if (s == end || *s++ != ':')
+                return false;
+        }
+        expect_value = true;
+    }
+    //nothing but space may follow the document
+    skip_json_space(s, end);
+    return s == end;
+}
+
+enum prov_section {
+    PROV_OTHER, PROV_ACTIVITY, PROV_ENTITY, PROV_USED, PROV_WAS_GENERATED_BY, PROV_WAS_INFORMED_BY, PROV_WAS_DERIVED_FROM
+};
+
+//the attributes holding the source and the destination of each kind of relation (in jsonparser.cpp order)
+static const char * prov_relation_from[] = {NULL, NULL, NULL, "prov:entity", "prov:activity", "prov:informant", "prov:usedEntity"};
+static const char * prov_relation_to[] = {NULL, NULL, NULL, "prov:activity", "prov:entity", "prov:informed", "prov:generatedEntity"};
+
+static int prov_section_of(const std::string& name) {
+    if (name == "activity")
+        return PROV_ACTIVITY;
+    if (name == "entity")
+        return PROV_ENTITY;
+    if (name == "used")
+        return PROV_USED;
+    if (name == "wasGeneratedBy")
+        return PROV_WAS_GENERATED_BY;
+    if (name == "wasInformedBy")
+        return PROV_WAS_INFORMED_BY;
+    if (name == "wasDerivedFrom")
+        return PROV_WAS_DERIVED_FROM;
+    return PROV_OTHER;
+}
+
+//Collects the records of one PROV-JSON document: {section: {id: record, ...}, ...}, where a record is an object of
+//attributes (or an array of them, for records sharing an id)
+//level is 1 in the document, 2 in a section, 3 in a record and more in the values of its attributes
+class prov_json_handler {
+public:
+
+    prov_json_handler(std::vector<prov_json_record>& records) : records(records) {}
+
+    void start_object() {
+        int level = current() + 1;
+        this->levels.push_back(level);
+        if (level == 3 && this->section != PROV_OTHER) {
+            this->records.push_back(prov_json_record());
+            prov_json_record& r = this->records.back();
+            r.section = this->section;
+            r.id = this->id;
+        }
+    }
+
+    void end_object() {
+        this->levels.pop_back();
+    }
+
+    void start_array() {
+        //the objects of an array in a section are records; any other array is nested in one
+        this->levels.push_back(current() == 2 ? 2 : JSON_MAX_DEPTH);
+    }
+
+    void end_array() {
+        this->levels.pop_back();
+    }
+
+    void key(const std::string& name) {
+        switch (current()) {
+            case 1: this->section = prov_section_of(name); break;
+            case 2: this->id = name; break;
+            case 3: this->attribute = name; break;
+        }
+    }
+
+    void value(const std::string& text, bool quoted) {
+        if (current() != 3 || this->section == PROV_OTHER)
+            return;
+        prov_json_record& r = this->records.back();
+        if (this->attribute == "prov:type")
+            r.type = text;
+        else if (this->section >= PROV_USED && this->attribute == prov_relation_from[this->section])
+            r.from = text;
+        else if (this->section >= PROV_USED && this->attribute == prov_relation_to[this->section])
+            r.to = text;
+    }
+
+private:
+
+    int current() const {
+        return this->levels.empty() ? 0 : this->levels.back();
+    }
+
+    std::vector<prov_json_record>& records;
+
+    std::vector<int> levels;
+
+    int section = PROV_OTHER;
+
+    std::string id;
+
+    std::string attribute;
+};
+
+static std::unordered_map<std::string, int32_t> type_id_map(const std::vector<std::string>& names) {
+    std::unordered_map<std::string, int32_t> ids;
+    for (size_t i = 0; i < names.size(); i++)
+        ids[names[i]] = (int32_t)i;
+    return ids;
+}
+
+//ids of the camflow type names (0 for a name that is not one); the maps are built once and only read after that,
+//so they can be shared by threads
+static int32_t camflow_vertex_type(const std::string& name) {
+    static const std::unordered_map<std::string, int32_t> ids = type_id_map(camflow_vertex_types);
+    std::unordered_map<std::string, int32_t>::const_iterator itr = ids.find(name);
+    return itr == ids.end() ? 0 : itr->second;
+}
+
+static int32_t camflow_edge_type(const std::string& name) {
+    static const std::unordered_map<std::string, int32_t> ids = type_id_map(camflow_edge_types);
+    std::unordered_map<std::string, int32_t>::const_iterator itr = ids.find(name);
+    return itr == ids.end() ? 0 : itr->second;
+}
+
+prov_json_converter::prov_json_converter(prov_edge_sink& sink) : sink(sink) {}
+
+//the records of one line; returns false if it is not a JSON document
+static bool parse_prov_json_line(const char * begin, const char * end, std::vector<prov_json_record>& records) {
+    records.clear();
+    prov_json_handler handler(records);
+    return parse_json(begin, end, handler);
+}
+
+static bool is_vertex_record(const prov_json_record& r) {
+    return r.section == PROV_ACTIVITY || r.section == PROV_ENTITY;
+}
+
+static bool is_edge_record(const prov_json_record& r) {
+    return r.section >= PROV_USED;
+}
+
+bool prov_json_converter::add_line(const char * begin, const char * end) {
+    if (!parse_prov_json_line(begin, end, this->records))
+        return false;
+    for (size_t i = 0; i < this->records.size(); i++) {
+        if (is_vertex_record(this->records[i]))
+            declare_vertex(this->records[i]);
+    }
+    for (size_t i = 0; i < this->records.size(); i++) {
+        if (is_edge_record(this->records[i]))
+            add_edge(this->records[i]);
+    }
+    return true;
+}
+
+int64_t prov_json_converter::find_vertex(const std::string& id) const {
+    std::unordered_map<std::string, uint32_t>::const_iterator itr = this->vertex_ids.find(id);
+    return itr == this->vertex_ids.end() ? -1 : (int64_t)itr->second;
+}
+
+void prov_json_converter::declare_vertex(const prov_json_record& r) {
+    //a vertex declared again keeps its first id and type
+    uint32_t vertex = (uint32_t)this->vertex_types.size();
+    if (!this->vertex_ids.insert(std::make_pair(r.id, vertex)).second)
+        return;
+    this->vertex_types.push_back(camflow_vertex_type(r.type));
+    resolve(r.id, vertex);
+}
+
+void prov_json_converter::add_edge(const prov_json_record& r) {
+    int32_t edge_type = camflow_edge_type(r.type);
+    int64_t src = find_vertex(r.from);
+    int64_t dst = find_vertex(r.to);
+    if (src >= 0 && dst >= 0) {
+        emit((uint32_t)src, (uint32_t)dst, edge_type);
+        return;
+    }
+    pending_edge edge;
+    edge.src = src >= 0 ? (uint32_t)src : 0;
+    edge.dst = dst >= 0 ? (uint32_t)dst : 0;
+    edge.edge_type = edge_type;
+    edge.missing = 0;
+    waiting_end end;
+    end.edge = this->waiting.size();
+    if (src < 0) {
+        //an edge from a vertex to itself waits for it once, for both ends
+        end.ends = r.to == r.from ? WAITING_SRC | WAITING_DST : WAITING_SRC;
+        this->waiting_for[r.from].push_back(end);
+        edge.missing++;
+    }
+    if (dst < 0 && (src >= 0 || r.to != r.from)) {
+        end.ends = WAITING_DST;
+        this->waiting_for[r.to].push_back(end);
+        edge.missing++;
+    }
+    this->waiting.push_back(edge);
+    this->npending++;
+}
+
+void prov_json_converter::resolve(const std::string& id, uint32_t vertex) {
+    std::unordered_map<std::string, std::vector<waiting_end>>::iterator itr = this->waiting_for.find(id);
+    if (itr == this->waiting_for.end())
+        return;
+    //the edges it completes are handed over in the order they were read
+    const std::vector<waiting_end>& ends = itr->second;
+    for (size_t i = 0; i < ends.size(); i++) {
+        pending_edge& edge = this->waiting[ends[i].edge];
+        if (ends[i].ends & WAITING_SRC)
+            edge.src = vertex;
+        if (ends[i].ends & WAITING_DST)
+            edge.dst = vertex;
+        if (--edge.missing == 0) {
+            emit(edge.src, edge.dst, edge.edge_type);
+            this->npending--;
+        }
+    }
+    this->waiting_for.erase(itr);
+    if (this->npending == 0)
+        this->waiting.clear();
+}
+
+void prov_json_converter::emit(uint32_t src, uint32_t dst, int32_t edge_type) {
+    prov_edge edge;
+    edge.src = src;
+    edge.dst = dst;
+    edge.src_type = this->vertex_types[src];
+    edge.dst_type = this->vertex_types[dst];
+    edge.edge_type = edge_type;
+    this->sink.add(edge);
+    this->nedges++;
+}
+
+uint32_t prov_json_parallel_converter::name_index(chunk& c, const std::string& name) {
+    std::pair<std::unordered_map<std::string, uint32_t>::iterator, bool> inserted = c.name_ids.insert(std::make_pair(name, (uint32_t)c.names.size()));
+    if (inserted.second)
+        c.names.push_back(name);
+    return inserted.first->second;
+}
+
+void prov_json_parallel_converter::parse_chunk(chunk& c) {
+    std::vector<prov_json_record> records;
+    std::vector<bool> declared;//by local index: only the first declaration in the chunk can be the first one in the log
+    const char * line = c.begin;
+    while (line < c.end) {
+        const char * newline = (const char *)memchr(line, '\n', c.end - line);
+        const char * line_end = newline == NULL ? c.end : newline + 1;
+        if (!parse_prov_json_line(line, line_end, records)) {
+            c.skipped++;
+        } else {
+            uint32_t order = 0;
+            for (size_t i = 0; i < records.size(); i++) {
+                if (!is_vertex_record(records[i]))
+                    continue;
+                uint32_t name = name_index(c, records[i].id);
+                declared.resize(c.names.size(), false);
+                if (!declared[name]) {
+                    declared[name] = true;
+                    chunk_declaration d = {name, camflow_vertex_type(records[i].type), c.lines, order};
+                    c.declarations.push_back(d);
+                }
+                order++;
+            }
+            order = 0;
+            for (size_t i = 0; i < records.size(); i++) {
+                if (!is_edge_record(records[i]))
+                    continue;
+                chunk_edge e;
+                e.from = name_index(c, records[i].from);
+                e.to = name_index(c, records[i].to);
+                e.type = camflow_edge_type(records[i].type);
+                e.line = c.lines;
+                e.order = order++;
+                c.edges.push_back(e);
+            }
+        }
+        c.lines++;
+        line = line_end;
+    }
+}
+
+long prov_json_parallel_converter::convert(const char * begin, const char * end, int nthreads) {
+    //a few chunks per thread, so that a chunk of long lines does not hold up the others
+    size_t nchunks = std::max(1, nthreads) * 4;
+    size_t chunk_size = std::max((size_t)(end - begin) / nchunks, (size_t)(1 << 16));
+    std::vector<chunk> chunks;
+    const char * start = begin;
+    while (start < end) {
+        const char * stop = start + std::min(chunk_size, (size_t)(end - start));
+        if (stop < end) {
+            const char * newline = (const char *)memchr(stop, '\n', end - stop);
+            stop = newline == NULL ? end : newline + 1;
+        }
+        chunks.push_back(chunk());
+        chunks.back().begin = start;
+        chunks.back().end = stop;
+        start = stop;
+    }
+    int n = (int)chunks.size();
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(nthreads)
+    for (int i = 0; i < n; i++)
+        parse_chunk(chunks[i]);
+
+    //the integer ids, in the order of the first declarations in the log
+    std::unordered_map<std::string, uint32_t> vertex_ids;
+    std::vector<int32_t> vertex_types;
+    std::vector<log_position> declared_at;
+    std::vector<uint64_t> first_line(n, 0);
+    long skipped = 0;
+    for (int i = 0; i < n; i++) {
+        first_line[i] = i == 0 ? 0 : first_line[i - 1] + chunks[i - 1].lines;
+        skipped += chunks[i].skipped;
+        for (size_t j = 0; j < chunks[i].declarations.size(); j++) {
+            const chunk_declaration& d = chunks[i].declarations[j];
+            if (!vertex_ids.insert(std::make_pair(chunks[i].names[d.name], (uint32_t)vertex_types.size())).second)
+                continue;
+            vertex_types.push_back(d.type);
+            declared_at.push_back((first_line[i] + d.line) << 32 | d.order);
+        }
+    }
+#pragma omp parallel for schedule(dynamic, 1) num_threads(nthreads)
+    for (int i = 0; i < n; i++) {
+        chunk& c = chunks[i];
+        c.global.resize(c.names.size());
+        for (size_t j = 0; j < c.names.size(); j++) {
+            std::unordered_map<std::string, uint32_t>::const_iterator itr = vertex_ids.find(c.names[j]);
+            c.global[j] = itr == vertex_ids.end() ? -1 : (int64_t)itr->second;
+        }
+        std::vector<std::string>().swap(c.names);
+        std::unordered_map<std::string, uint32_t>().swap(c.name_ids);
+    }
+
+    //the edges in the order of the single pass: an edge complete at its own line comes after the edges completed by
+    //the declarations up to that line
+    std::priority_queue<deferred_edge, std::vector<deferred_edge>, std::greater<deferred_edge>> deferred;
+    for (int i = 0; i < n; i++) {
+        const chunk& c = chunks[i];
+        for (size_t j = 0; j < c.edges.size(); j++) {
+            const chunk_edge& e = c.edges[j];
+            int64_t src = c.global[e.from];
+            int64_t dst = c.global[e.to];
+            if (src < 0 || dst < 0) {
+                this->npending++;
+                continue;
+            }
+            uint64_t line = first_line[i] + e.line;
+            prov_edge edge;
+            edge.src = (uint32_t)src;
+            edge.dst = (uint32_t)dst;
+            edge.src_type = vertex_types[src];
+            edge.dst_type = vertex_types[dst];
+            edge.edge_type = e.type;
+            log_position at = std::max(declared_at[src], declared_at[dst]);
+            if ((at >> 32) > line) {
+                deferred_edge later = {at, line << 32 | e.order, edge};
+                deferred.push(later);
+                continue;
+            }
+            while (!deferred.empty() && (deferred.top().at >> 32) <= line) {
+                this->sink.add(deferred.top().edge);
+                deferred.pop();
+                this->nedges++;
+            }
+            this->sink.add(edge);
+            this->nedges++;
+        }
+    }
+    while (!deferred.empty()) {
+        this->sink.add(deferred.top().edge);
+        deferred.pop();
+        this->nedges++;
+    }
+    this->nvertices = (uint32_t)vertex_types.size();
+    return skipped;
+}
+
+//map the log and convert its chunks on nthreads threads
+static prov_json_stats convert_prov_json_mapped(const std::string& input, int nthreads, prov_edge_sink& sink) {
+    int fd = open(input.c_str(), O_RDONLY);
+    struct stat st;
+    bool opened = fd >= 0 && fstat(fd, &st) == 0;
+    if (!opened)
+        logstream(LOG_FATAL) << "Could not open " << input << ": " << strerror(errno) << std::endl;
+    assert(opened);
+    size_t size = st.st_size;
+    const char * data = NULL;
+    if (size > 0) {
+        void * mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED)
+            logstream(LOG_FATAL) << "Could not map " << input << ": " << strerror(errno) << std::endl;
+        assert(mapped != MAP_FAILED);
+        data = (const char *)mapped;
+    }
+    close(fd);
+    prov_json_parallel_converter converter(sink);
+    prov_json_stats stats;
+    stats.skipped = converter.convert(data, data + size, nthreads);
+    if (data != NULL)
+        munmap((void *)data, size);
+    stats.vertices = converter.vertices();
+    stats.edges = converter.edges();
+    stats.dropped = converter.pending();
+    return stats;
+}
+
+prov_json_stats convert_prov_json_log(const std::string& input, int nthreads, prov_edge_sink& sink) {
+    if (nthreads > 1 && input != "-")
+        return convert_prov_json_mapped(input, nthreads, sink);
+    FILE * in = input == "-" ? stdin : fopen(input.c_str(), "r");
+    if (in == NULL)
+        logstream(LOG_FATAL) << "Could not open " << input << ": " << strerror(errno) << std::endl;
+    assert(in != NULL);
+    prov_json_converter converter(sink);
+    prov_json_stats stats;
+    stats.skipped = 0;
+    char * line = NULL;
+    size_t capacity = 0;
+    ssize_t length;
+    while ((length = getline(&line, &capacity, in)) != -1) {
+        if (!converter.add_line(line, line + length))
+            stats.skipped++;
+    }
+    free(line);
+    if (in != stdin)
+        fclose(in);
+    stats.vertices = converter.vertices();
+    stats.edges = converter.edges();
+    stats.dropped = converter.pending();
+    return stats;
+}
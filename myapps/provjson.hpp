@@ -0,0 +1,207 @@
+//
+//  provjson.hpp
+//  graphchi_xcode
+//
+
+#ifndef provjson_hpp
+#define provjson_hpp
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "provedges.hpp"
+
+//Event driven JSON reader: scans [begin, end) once and reports every container, key and scalar to the handler as it
+//goes, without building a tree. The handler provides
+//  void start_object(); void end_object(); void start_array(); void end_array();
+//  void key(const std::string& name); void value(const std::string& text, bool quoted);
+//(a scalar other than a string is reported as its text: 12, true, null...)
+//Returns false on malformed input; the handler has then seen the events before the error
+template <typename Handler>
+bool parse_json(const char * begin, const char * end, Handler& handler);
+
+//one record of a PROV-JSON document, with the attributes the converters need
+struct prov_json_record {
+    int section;
+    std::string id;
+    std::string type;
+    std::string from;//source and destination of a relation
+    std::string to;
+};
+
+//Single pass converter of a camflow PROV-JSON log (one JSON document per line) to an edge list "src dst src_type:dst_type:edge_type"
+//Vertices (activity and entity records) get integer ids in the order they are first declared in the log. jsonparser.cpp
+//numbers the activities of a line before its entities, each section in jsoncpp's (sorted) key order, so its vertex ids differ:
+//the two edge lists are the same graph up to a renumbering of the vertices
+//Relations (used, wasGeneratedBy, wasInformedBy, wasDerivedFrom) are handed to the sink as soon as both of their vertices
+//are known; a relation to a vertex that is not declared yet waits for it. The records of a line are applied at the end
+//of the line (the vertices first), so a line that is not valid JSON (the log has plain text lines) adds nothing
+//Unknown type names are type 0, as in jsonparser.cpp
+class prov_json_converter {
+public:
+
+    prov_json_converter(prov_edge_sink& sink);
+
+    //convert one line; returns false if it is not a JSON document
+    bool add_line(const char * begin, const char * end);
+
+    //number of vertices declared so far
+    uint32_t vertices() const {
+        return (uint32_t)this->vertex_types.size();
+    }
+
+    //number of edges handed to the sink so far
+    uint64_t edges() const {
+        return this->nedges;
+    }
+
+    //number of edges still waiting for a vertex; at the end of the log they are dropped (they have no vertex to attach to)
+    uint64_t pending() const {
+        return this->npending;
+    }
+
+private:
+
+    struct pending_edge {
+        uint32_t src;
+        uint32_t dst;
+        int32_t edge_type;
+        uint8_t missing;//number of vertices not known yet
+    };
+
+    enum {WAITING_SRC = 1, WAITING_DST = 2};
+
+    struct waiting_end {
+        size_t edge;//index in waiting
+        uint8_t ends;//which ends of the edge the vertex is
+    };
+
+    //integer id of a declared vertex, or -1
+    int64_t find_vertex(const std::string& id) const;
+
+    void declare_vertex(const prov_json_record& r);
+
+    void add_edge(const prov_json_record& r);
+
+    //fill in the vertex just declared with the given string id in the edges waiting for it, and hand the complete ones to the sink
+    void resolve(const std::string& id, uint32_t vertex);
+
+    void emit(uint32_t src, uint32_t dst, int32_t edge_type);
+
+    prov_edge_sink& sink;
+
+    std::unordered_map<std::string, uint32_t> vertex_ids;//string id of every declared vertex to its integer id
+
+    std::vector<int32_t> vertex_types;//type of every declared vertex, by integer id
+
+    std::vector<pending_edge> waiting;//edges waiting for a vertex; cleared once none is left
+
+    std::unordered_map<std::string, std::vector<waiting_end>> waiting_for;//string id of an undeclared vertex to the edges (in waiting) it completes
+
+    std::vector<prov_json_record> records;//records of the line being parsed
+
+    uint64_t nedges = 0;
+
+    uint64_t npending = 0;
+};
+
+//Converter of a whole log in memory (a mapped file) on several threads, with the same output as prov_json_converter
+//The log is split into chunks at line boundaries, and every chunk is parsed on its own thread into a table of the string
+//ids it names, the vertices it declares and the relations it holds (by local index in that table). The chunks are then
+//merged in order: the vertices get their integer ids in the order they are first declared, as in one pass over the log,
+//and every relation gets the position at which the single pass would hand it to the sink (its own line if both of its
+//vertices are declared by then, else the declaration of the last one), so the edges come out in the same order for
+//any number of threads and chunks
+class prov_json_parallel_converter {
+public:
+
+    prov_json_parallel_converter(prov_edge_sink& sink) : sink(sink) {}
+
+    //convert the lines of [begin, end) on nthreads threads; returns the number of lines that are not JSON
+    long convert(const char * begin, const char * end, int nthreads);
+
+    uint32_t vertices() const {
+        return this->nvertices;
+    }
+
+    uint64_t edges() const {
+        return this->nedges;
+    }
+
+    //number of edges dropped because a vertex of them is never declared
+    uint64_t pending() const {
+        return this->npending;
+    }
+
+private:
+
+    //a position in the log: the line in the high half, the index of the record among the vertices (or relations) of
+    //the line in the low half
+    typedef uint64_t log_position;
+
+    struct chunk_declaration {
+        uint32_t name;//local index of the string id
+        int32_t type;
+        uint32_t line;//line in the chunk
+        uint32_t order;
+    };
+
+    struct chunk_edge {
+        uint32_t from;
+        uint32_t to;
+        int32_t type;
+        uint32_t line;
+        uint32_t order;
+    };
+
+    struct chunk {
+        const char * begin;
+        const char * end;
+        uint32_t lines = 0;
+        long skipped = 0;
+        std::vector<std::string> names;
+        std::unordered_map<std::string, uint32_t> name_ids;
+        std::vector<chunk_declaration> declarations;
+        std::vector<chunk_edge> edges;
+        std::vector<int64_t> global;//integer id of every name, -1 if it is never declared
+    };
+
+    //an edge the single pass would hand over after its own line
+    struct deferred_edge {
+        log_position at;//the declaration that completes it
+        log_position read;//its own position, which orders the edges completed by the same declaration
+        prov_edge edge;
+
+        bool operator>(const deferred_edge& other) const {
+            return this->at != other.at ? this->at > other.at : this->read > other.read;
+        }
+    };
+
+    static void parse_chunk(chunk& c);
+
+    static uint32_t name_index(chunk& c, const std::string& name);
+
+    prov_edge_sink& sink;
+
+    uint32_t nvertices = 0;
+
+    uint64_t nedges = 0;
+
+    uint64_t npending = 0;
+};
+
+//what a conversion of a whole log did
+struct prov_json_stats {
+    long skipped;//lines that are not JSON
+    uint32_t vertices;
+    uint64_t edges;
+    uint64_t dropped;//edges to vertices that are never declared
+};
+
+//convert the log at input ("-" for the standard input) to the sink: on nthreads threads with
+//prov_json_parallel_converter if it is a file and nthreads > 1, else in one pass as the lines are read
+prov_json_stats convert_prov_json_log(const std::string& input, int nthreads, prov_edge_sink& sink);
+
+#include "provjson.cpp"
+#endif /* provjson_hpp */
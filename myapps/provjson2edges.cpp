@@ -0,0 +1,75 @@
+//
+//  provjson2edges.cpp
+//  graphchi_xcode
+//
+//  Converts a camflow PROV-JSON log to an edge list in one pass (see prov_json_converter), without the DOM and the second
+//  read of jsonparser.cpp. Lines are converted as they are read, so the log can be a pipe from the audit service
+//  Usage: bin/myapps/provjson2edges input server/log1.txt output server/edgeList1.txt [format text|binary] [threads N]
+//  input - reads the standard input; format binary writes the binary edge list of provedges.hpp, which main shards
+//  straight from its mapping; threads N (0 for every core) maps the log and converts it in chunks on N threads, with
+//  the same output (see prov_json_parallel_converter)
+//
+
+#include <string>
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+#include <omp.h>
+#include "global.h"
+#include "provedges.hpp"
+#include "provjson.hpp"
+#include "graphchi_basic_includes.hpp"
+
+using namespace graphchi;
+
+//edge list as text, in the format of jsonparser.cpp
+class text_edge_sink : public prov_edge_sink {
+public:
+
+    text_edge_sink(FILE * out) : out(out) {}
+
+    void add(const prov_edge& edge) {
+        fprintf(this->out, "%u\t%u\t%d:%d:%d\n", edge.src, edge.dst, edge.src_type, edge.dst_type, edge.edge_type);
+    }
+
+private:
+
+    FILE * out;
+};
+
+int main(int argc, const char ** argv) {
+    graphchi_init(argc, argv);
+    std::string input = get_option_string("input");
+    std::string output = get_option_string("output");
+    std::string format = get_option_string("format", "text");
+    int nthreads = get_option_int("threads", 1);
+    if (nthreads <= 0)
+        nthreads = omp_get_max_threads();
+    if (format != "text" && format != "binary")
+        logstream(LOG_FATAL) << "Unknown format " << format << " (text or binary)" << std::endl;
+    assert(format == "text" || format == "binary");
+
+    prov_json_stats stats;
+    if (format == "binary") {
+        prov_edges_writer writer(output, camflow_vertex_types, camflow_edge_types);
+        stats = convert_prov_json_log(input, nthreads, writer);
+        if (!writer.close())
+            logstream(LOG_FATAL) << "Could not write " << output << std::endl;
+    } else {
+        FILE * out = fopen(output.c_str(), "w");
+        if (out == NULL)
+            logstream(LOG_FATAL) << "Could not open " << output << std::endl;
+        assert(out != NULL);
+        text_edge_sink sink(out);
+        stats = convert_prov_json_log(input, nthreads, sink);
+        if (fclose(out) != 0)
+            logstream(LOG_FATAL) << "Could not write " << output << std::endl;
+    }
+
+    if (stats.dropped > 0)
+        logstream(LOG_WARNING) << "Dropped " << stats.dropped << " edges to vertices that are never declared" << std::endl;
+    logstream(LOG_INFO) << "Wrote " << stats.edges << " edges between " << stats.vertices << " vertices to " << output << " (skipped "
+        << stats.skipped << " lines that are not JSON)" << std::endl;
+    return 0;
+}
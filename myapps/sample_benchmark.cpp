@@ -0,0 +1,156 @@
+//
+//  sample_benchmark.cpp
+//  graphchi_xcode
+//
+//  Compares sampled relabeling (sample in main.cpp, relabel_sample in vertex.cpp) with exact relabeling. Every graph is
+//  relabeled exactly first (building the relabel table), then sampled with every fraction and seed the way the detection
+//  stage relabels a monitored graph. For each fraction it reports the KL and Hellinger distances of the sampled count arrays
+//  from the exact ones, the Hellinger bound of the sample and how often the distance is within it, the error of the pairwise
+//  distances between the graphs (what clustering and detection see), the share of vertices updated and the relabel time
+//  Sampled labels outside the exact relabel table would be labels the neighborhoods got wrong: the last column must stay 0
+//  Usage: bin/myapps/sample_benchmark ngraphs 8 file0 dataset1/edgeList1.txt ... file7 dataset1/edgeList8.txt niters 4 filetype edgelist
+//  [fractions 0.05,0.1,0.2,0.5] [seeds 3]
+//  The graphs are sharded again before every run (relabeling overwrites the types on the edges); sharding is not timed
+//
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <cmath>
+#include <cstdlib>
+#include <chrono>
+#include "global.h"
+#include "provedges.hpp"
+#include "kernelmaps.hpp"
+#include "profile.hpp"
+#include "vertex.hpp"
+#include "graphchi_basic_includes.hpp"
+
+using namespace graphchi;
+
+//detection relabeling of one graph with a sample, keeping the estimate
+struct sampled_detection_run {
+    graphchi_engine<VertexDataType, EdgeDataType> &engine;
+    int niters;
+    std::map<int, int> &label_map;
+    relabel_sample sample;
+    sample_estimate estimate;
+
+    template <typename Keys>
+    void run() {
+        VertexRelabelDetection<Keys> program;
+        program.label_map = &this->label_map;
+        program.sample = this->sample;
+        this->engine.run(program, program.sample.iterations((this->niters + 1) / 2));
+        this->estimate = program.sample.finish(0, this->label_map);
+    }
+};
+
+//shards of the graph with the types of the edge list (relabeling overwrites them). The sharder prints its metrics to
+//std::cout, which is muted meanwhile to keep them out of the table
+int reshard(const std::string& filename) {
+    std::ostringstream muted;
+    std::streambuf * out = std::cout.rdbuf(muted.rdbuf());
+    int nshards = reshard_graph(filename, get_option_string("nshards", "auto"));
+    std::cout.rdbuf(out);
+    return nshards;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, const char ** argv) {
+    graphchi_init(argc, argv);
+    metrics m("sample_benchmark");
+    global_logger().set_log_level(LOG_WARNING);
+    int num_graphs = get_option_int("ngraphs");
+    int niters = get_option_int("niters", 4);
+    int nseeds = get_option_int("seeds", 3);
+    std::vector<double> fractions;
+    std::stringstream fraction_list(get_option_string("fractions", "0.05,0.1,0.2,0.5"));
+    std::string fraction;
+    while (std::getline(fraction_list, fraction, ','))
+        fractions.push_back(atof(fraction.c_str()));
+    std::vector<std::string> filenames;
+    for (int i = 0; i < num_graphs; i++) {
+        std::stringstream name;
+        name << "file" << i;
+        filenames.push_back(get_option_string(name.str().c_str()));
+    }
+
+    KernelMaps* km = KernelMaps::get_instance();
+    km->resetMaps();
+    km->set_relabel_variant(parse_relabel_variant(get_option_string("relabel", "edge_aware"), get_option_int("take_edge_label", 0) != 0));
+    double exact_seconds = 0.0;
+    for (int i = 0; i < num_graphs; i++) {
+        int nshards = reshard(filenames[i]);
+        km->insert_label_map();
+        graphchi_engine<VertexDataType, EdgeDataType> engine(filenames[i], nshards, false, m);
+        relabel_run f = {engine, niters, NULL, 0, edge_label_buffers(), relabel_convergence(), relabel_sample(), 0};
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        with_relabel_keys(km->get_relabel_variant(), f);
+        exact_seconds += seconds_since(start);
+    }
+    std::vector<sparse_count_array> exact;
+    for (int i = 0; i < num_graphs; i++)
+        exact.push_back(km->generate_count_array(km->label_map(i)));
+    std::vector<double> exact_pairs[2];
+    for (int method = 0; method < 2; method++)
+        for (int i = 0; i < num_graphs; i++)
+            for (int j = i + 1; j < num_graphs; j++)
+                exact_pairs[method].push_back(calculate_distance2(method, exact[i], exact[j]));
+
+    std::cout << "exact relabeling: " << exact_seconds << " s" << std::endl;
+    std::cout << "fraction\troots\tupdated\tseconds\tKL mean\tKL max\tHellinger mean\tHellinger max\tHellinger bound\twithin bound"
+        << "\tpair KL error\tpair Hellinger error\tunknown labels" << std::endl;
+    for (size_t f = 0; f < fractions.size(); f++) {
+        double roots = 0.0, updated = 0.0, seconds = 0.0, bound = 0.0, within = 0.0;
+        double distance_sum[2] = {0.0, 0.0}, distance_max[2] = {0.0, 0.0}, pair_error[2] = {0.0, 0.0};
+        long unknown = 0;
+        for (int seed = 0; seed < nseeds; seed++) {
+            std::vector<sparse_count_array> sampled;
+            for (int i = 0; i < num_graphs; i++) {
+                int nshards = reshard(filenames[i]);
+                graphchi_engine<VertexDataType, EdgeDataType> engine(filenames[i], nshards, true, m);
+                relabel_sample sample;
+                sample.fraction = fractions[f];
+                sample.seed = seed;
+                std::map<int, int> label_map;
+                sampled_detection_run run = {engine, niters, label_map, sample, sample_estimate()};
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                with_relabel_keys(km->get_relabel_variant(), run);
+                seconds += seconds_since(start);
+                for (std::map<int, int>::iterator itr = label_map.begin(); itr != label_map.end(); itr++)
+                    if (itr->first > km->get_counter())
+                        unknown++;
+                sampled.push_back(km->generate_count_array(label_map));
+
+                roots += run.estimate.roots / (double)std::max(1L, run.estimate.vertices);
+                updated += engine.num_updates() / ((double)engine.num_vertices() * std::max(1, niters));
+                bound += run.estimate.hellinger();
+                for (int method = 0; method < 2; method++) {
+                    double distance = calculate_distance2(method, exact[i], sampled[i]);
+                    distance_sum[method] += distance;
+                    distance_max[method] = std::max(distance_max[method], distance);
+                    if (method == 1 && distance <= run.estimate.hellinger())
+                        within++;
+                }
+            }
+            for (int method = 0; method < 2; method++) {
+                size_t k = 0;
+                for (int i = 0; i < num_graphs; i++)
+                    for (int j = i + 1; j < num_graphs; j++)
+                        pair_error[method] += fabs(calculate_distance2(method, sampled[i], sampled[j]) - exact_pairs[method][k++]);
+            }
+        }
+        double runs = (double)num_graphs * nseeds;
+        double pairs = std::max(1.0, num_graphs * (num_graphs - 1) / 2.0 * nseeds);
+        std::cout << fractions[f] << "\t" << roots / runs << "\t" << updated / runs << "\t" << seconds / nseeds << "\t"
+            << distance_sum[0] / runs << "\t" << distance_max[0] << "\t" << distance_sum[1] / runs << "\t" << distance_max[1] << "\t"
+            << bound / runs << "\t" << within / runs << "\t" << pair_error[0] / pairs << "\t" << pair_error[1] / pairs << "\t" << unknown << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,108 @@
+//
+//  scoring.cpp
+//  graphchi_xcode
+//
+
+#include <algorithm>
+#include "scoring.hpp"
+#include "attribution.hpp"
+#include "graphchi_basic_includes.hpp"
+
+using namespace graphchi;
+
+void recluster_profile(profile& pf, const std::vector<sparse_count_array>& count_arrays, const std::vector<std::vector<int>>& clusters) {
+    pf.reset_arrays();
+    for (size_t i = 0; i < clusters.size(); i++) {
+        if (clusters[i].size() == 0)
+            continue;
+        std::vector<const sparse_count_array*> members;
+        for (size_t j = 0; j < clusters[i].size(); j++)
+            members.push_back(&count_arrays[clusters[i][j]]);
+        sparse_count_array centroid = mean_count_array(members);
+        double max_dis = 0.0;
+        for (size_t j = 0; j < members.size(); j++) {
+            double dis = pf.calculate_distance(pf.get_metric(), *members[j], centroid);
+            if (dis > max_dis)
+                max_dis = dis;
+            pf.add_array(*members[j]);
+        }
+        pf.add_centroid(std::move(centroid));
+        pf.add_max_distance_from_centroid(max_dis);
+    }
+}
+
+bool score_instance(profile& pf, const sparse_count_array& instance, bool update_profile, std::ostream& out) {
+    const std::vector<sparse_count_array>& profile_centroids = pf.get_centroids();
+    const std::vector<double>& profile_distances = pf.get_distances();
+    std::vector<double> monitor_distances;
+    //calculate distance between the monitored count array and the centroid
+    for (size_t i = 0 ; i < profile_centroids.size(); i++) {
+        double monitor_distance = pf.calculate_distance(pf.get_metric(), profile_centroids[i], instance);
+        monitor_distances.push_back(monitor_distance);
+    }
+    
+    //debug only:
+    out << "Distances of monitored instance: ";
+    for (size_t i = 0; i < monitor_distances.size(); i++) {
+        out << monitor_distances[i] << " ";
+    }
+    out << std::endl;
+    
+    //test if the monitored program belonged to any of the cluster (i.e., within the radius)
+    bool need_recluster = true;
+    for (size_t i = 0; i < monitor_distances.size(); i++) {
+        if (monitor_distances[i] <= profile_distances[i]) {
+            need_recluster = false;
+        }
+    }
+    
+    bool bad_instance = false;
+    if (!need_recluster)
+        out << "This monitored instance is normal..." << std::endl;
+    else {
+        out << "This monitored instance is outside the radius of any cluster... Recluster now..." << std::endl;
+        std::vector<sparse_count_array> total_count_arrays;
+        total_count_arrays.reserve(pf.get_count_arrays().size() + 1);
+        total_count_arrays = pf.get_count_arrays();
+        total_count_arrays.push_back(instance);
+        out << "# of arrays in total_count_arrays: " << total_count_arrays.size() << std::endl;
+        std::vector<sparse_count_array> total_centroids = pf.get_centroids();
+        total_centroids.push_back(instance);
+        out << "# of arrays in total_centroids: " << total_centroids.size() << std::endl;
+        
+        std::pair<std::vector<std::vector<int>>, std::vector<std::vector<double>>> cluster_monitor_results = kmeans_monitor(total_centroids.size(), total_count_arrays, total_centroids, get_option_int("kmeans_max_iters", 0), pf.get_metric());
+        std::vector<std::vector<int>>& cluster_monitor = cluster_monitor_results.first;
+        
+        //for debugging: print out elements in a cluster
+        for (std::vector<std::vector<int>>::iterator it = cluster_monitor.begin(); it != cluster_monitor.end(); it++) {
+            out << "ReCluster (Monitoring): ";
+            for (std::vector<int>::iterator itr2 = it->begin(); itr2 != it->end(); itr2++) {
+                out << *itr2 << " ";
+            }
+            out << std::endl;
+        }
+        
+        for (size_t j = 0; j < cluster_monitor.size(); j++) {
+            if (cluster_monitor[j].size() == 1 && cluster_monitor[j][0] == (int)pf.get_count_arrays().size()) {
+                out << "This monitored instance is abnormal!" << std::endl;
+                bad_instance = true;
+            }
+        }
+        //the labels that set it apart: the largest terms of its distance from the nearest centroid (attribution N, 0 for none)
+        if (bad_instance && !monitor_distances.empty()) {
+            int top = get_option_int("attribution", 10);
+            size_t nearest = std::min_element(monitor_distances.begin(), monitor_distances.end()) - monitor_distances.begin();
+            if (top > 0)
+                report_attribution(out, pf.get_metric(), instance, profile_centroids[nearest], (int)nearest, monitor_distances[nearest], top);
+        }
+        if (!bad_instance) {
+            out << "This monitored instance is actually normal..." << std::endl;
+            if (update_profile) {
+                recluster_profile(pf, total_count_arrays, cluster_monitor);
+                out << "Profile updated: " << pf.get_centroids().size() << " clusters, " << pf.get_count_arrays().size() << " count arrays" << std::endl;
+            }
+        }
+    }
+    
+    return !bad_instance;
+}
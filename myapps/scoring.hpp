@@ -0,0 +1,27 @@
+//
+//  scoring.hpp
+//  graphchi_xcode
+//
+
+#ifndef scoring_hpp
+#define scoring_hpp
+
+#include <vector>
+#include <iostream>
+#include "countarray.hpp"
+#include "profile.hpp"
+
+//Clustering state of the profile after a recluster: every non-empty cluster of count_arrays becomes a cluster of the profile,
+//with the mean of its members as centroid and the largest distance of a member to it as radius
+void recluster_profile(profile& pf, const std::vector<sparse_count_array>& count_arrays, const std::vector<std::vector<int>>& clusters);
+
+//Compare the count array of a monitored instance to the profile
+//The instance is normal if it is within the radius of a cluster. Otherwise the profile is reclustered together with it (kmeans_monitor),
+//and it is abnormal if it ends up alone in a cluster
+//If update_profile is set and the recluster finds the instance normal, the profile takes the new clustering, instance included
+//The report goes to out. Without update_profile the profile is only read, so instances can be scored concurrently
+//Returns whether the instance is normal
+bool score_instance(profile& pf, const sparse_count_array& instance, bool update_profile, std::ostream& out = std::cout);
+
+#include "scoring.cpp"
+#endif /* scoring_hpp */
@@ -0,0 +1,107 @@
+//
+//  streaming.cpp
+//  graphchi_xcode
+//
+//  Streaming mode: scores one instance whose graph keeps growing, with the model of an earlier run of main (save_model)
+//  Usage: bin/myapps/streaming load_model model.bin stream_base base.txt stream edges.txt [burst 1000] [window 0] [filetype edgelist]
+//  The window removes expired edges with the deletions of the dynamic engine, so this binary is built with SUPPORT_DELETIONS;
+//  main is not, and its engines skip the deleted-edge checks of every edge they load
+//
+
+#define SUPPORT_DELETIONS 1
+
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <functional>
+#include <chrono>
+#include <limits>
+#include <cassert>
+#include "kernelmaps.hpp"
+#include "profile.hpp"
+#include "global.h"
+#include "incrementalrelabel.hpp"
+#include "modelsnapshot.hpp"
+#include "scoring.hpp"
+#include "provedges.hpp"
+#include "graphchi_basic_includes.hpp"
+#include "logger/logger.hpp"
+
+using namespace graphchi;
+
+//Streaming mode: one instance whose graph keeps growing. The engine starts on the edge list stream_base, then the edges of
+//stream (an edge list, or "-" for stdin) are added in bursts of burst edges (default 1000; an empty line ends a burst early).
+//Labels are updated incrementally (IncrementalVertexRelabel) and the instance is scored again after every burst
+//window W (0, the default, keeps every edge) scores the graph of the last W units of time only: edges carry a timestamp as a
+//fourth type field (src_type:dst_type:edge_type:time, a non-negative 64-bit number such as jiffies or epoch milliseconds) and expire once the stream has seen a timestamp W later, so the graph,
+//the histogram and the cost of a burst stay bounded however long the stream runs
+//The profile is not updated
+void run_streaming(profile& pf, int niters, metrics& m) {
+    std::string base = get_option_string("stream_base");
+    std::string stream = get_option_string("stream");
+    int burst = get_option_int("burst", 1000);
+    int64_t window = (int64_t)get_option_long("window", 0);
+    if (window < 0)
+        logstream(LOG_FATAL) << "window must not be negative" << std::endl;
+    assert(window >= 0);
+    KernelMaps* km = KernelMaps::get_instance();
+    
+    std::ifstream stream_file;
+    if (stream != "-") {
+        stream_file.open(stream.c_str());
+        if (!stream_file.is_open())
+            logstream(LOG_FATAL) << "Could not open edge stream " << stream << std::endl;
+        assert(stream_file.is_open());
+    }
+    EdgeBurstQueue bursts;
+    std::thread reader(read_edge_bursts, std::ref(stream == "-" ? std::cin : stream_file), (size_t)burst, std::ref(bursts));
+    
+    int nshards = convert_graph_if_notexists(base, get_option_string("nshards", "auto"));
+    graphchi_dynamicgraph_engine<VertexDataType, EdgeDataType> engine(base, nshards, true, m);
+    //edges are only written to remove the expired ones
+    engine.set_modifies_inedges(window > 0);
+    engine.set_modifies_outedges(window > 0);
+    monitor_profile monitored;
+    IncrementalVertexRelabel program(engine, bursts, niters, monitored.label_map, window);
+    int nwaves = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    program.wave_finished = [&](size_t nedges, size_t nexpired, size_t nupdates) {
+        monitored.count_array = km->generate_count_array(monitored.label_map);
+        bool normal = score_instance(pf, monitored.count_array, false);
+        double latency = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Stream: " << (nwaves == 0 ? "base graph" : "burst") << " " << nwaves << " (" << nedges << " edges, "
+                  << (window > 0 ? std::to_string(nexpired) + " expired, " : std::string()) << nupdates << " vertex updates) is "
+                  << (normal ? "normal" : "abnormal") << " (" << latency << " s)" << std::endl;
+        nwaves++;
+        start = std::chrono::steady_clock::now();
+    };
+    //the engine stops by itself once the stream has ended and nothing is scheduled
+    engine.run(program, std::numeric_limits<int>::max());
+    reader.join();
+}
+
+int main(int argc, const char ** argv) {
+    graphchi_init(argc, argv);
+    metrics m("Streaming Detection");
+    
+    //the kernelmap and the profile come from the learning stage of main; niters, the relabel variant and the metric with them
+    std::string model_path = get_option_string("load_model");
+    KernelMaps* km = KernelMaps::get_instance();
+    km->resetMaps();
+    profile pf;
+    pf.reset_arrays();
+    int niters;
+    bool converge;
+    bool loaded = load_model(model_path, km, pf, niters, converge);
+    if (!loaded)
+        logstream(LOG_FATAL) << "Could not load model " << model_path << std::endl;
+    assert(loaded);
+    
+    run_streaming(pf, niters, m);
+    
+    //report_metrics 1: to the reporters of conf/graphchi.cnf
+    if (get_option_int("report_metrics", 0) != 0)
+        metrics_report(m);
+    return 0;
+}
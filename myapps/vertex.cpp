@@ -9,32 +9,623 @@
 #include <iostream>
 #include <stdlib.h>
 #include <map>
+#include <unordered_set>
 #include <thread>
 #include <mutex>
 #include <cstdlib>
 #include <vector>
 #include <sstream>
 #include <cassert>
+#include <cmath>
+#include <algorithm>
 #include "graphchi_basic_includes.hpp"
+#include "util/qsort.hpp"
 #include "logger/logger.hpp"
 #include "vertex.hpp"
 #include "kernelmaps.hpp"
+#include "labeltable.hpp"
+#include "graphunion.hpp"
 #include "global.h"
 
 using namespace graphchi;
 
+//the w3c type of a vertex, used as its label in the first iteration
+//The value can be obtained from any outedge (from src_type) or in_edge from (dst_type)
+int initial_vertex_type(graphchi_vertex<VertexDataType, EdgeDataType> &vertex) {
+    graphchi_edge<EdgeDataType> * outedge = vertex.random_outedge();
+    //if the node has no outedge, we get a first inedge in the queue
+    if (outedge == NULL) {
+        graphchi_edge<EdgeDataType> * inedge = vertex.inedge(0);
+        //get the dst_type from inedge
+        return inedge->get_data().new_dst;
+    } else {
+        //get the src_type from outedge
+        return outedge->get_data().new_src;
+    }
+}
+
+//slots of the scratch arena of an update thread (graphchi_context::scratch) that hold the keys of the vertex being relabeled,
+//so that the key policies do not allocate on every update
+enum {SCRATCH_IN_KEY, SCRATCH_OUT_KEY, SCRATCH_IN_PAIRS, SCRATCH_OUT_PAIRS};
+
+//sort the labels of a key after the vertex label; most vertices have a few neighbors, which smallSort handles without std::sort
+template <typename T>
+void sort_neighbor_labels(std::vector<T> &key, size_t first) {
+    smallSort(key.data() + first, (int)(key.size() - first));
+}
+
+//Build the RELABEL_NEIGHBOR tuples of a vertex: its own label followed by the sorted labels of its incoming (in_key) or outgoing (out_key) neighbors
+//in_label(i) and out_label(i) give the label of the neighbor on the i-th in/out edge in the previous update phase
+//In the second update phase (edge_types) edge types are included: each neighbor contributes a (label, edge type) pair.
+//The string keys this replaces appended the outgoing pairs to the incoming key in that iteration and left the outgoing key with the vertex label only.
+//We keep that layout so that relabeled ids stay the same as before. The pairs are collected in the scratch arena
+template <typename InLabel, typename OutLabel>
+void build_neighbor_keys(graphchi_vertex<VertexDataType, EdgeDataType> &vertex, int self_label, bool edge_types, InLabel in_label, OutLabel out_label,
+                         std::vector<int> &in_key, std::vector<int> &out_key, scratch_arena &scratch) {
+    in_key.clear();
+    out_key.clear();
+    in_key.push_back(self_label);
+    out_key.push_back(self_label);
+    if (edge_types) {
+        std::vector<std::pair<int, int>> &incoming_pair_label_vec = scratch.get<std::pair<int, int>>(SCRATCH_IN_PAIRS);
+        std::vector<std::pair<int, int>> &outgoing_pair_label_vec = scratch.get<std::pair<int, int>>(SCRATCH_OUT_PAIRS);
+        for(int i=0; i < vertex.num_inedges(); i++) {
+            incoming_pair_label_vec.push_back(std::pair<int, int>(in_label(i), vertex.inedge(i)->get_data().edge));
+        }
+        for (int i=0; i < vertex.num_outedges(); i++) {
+            outgoing_pair_label_vec.push_back(std::pair<int, int>(out_label(i), vertex.outedge(i)->get_data().edge));
+        }
+        sort_neighbor_labels(incoming_pair_label_vec, 0);
+        sort_neighbor_labels(outgoing_pair_label_vec, 0);
+        for (std::vector<std::pair<int, int>>::iterator it = incoming_pair_label_vec.begin(); it != incoming_pair_label_vec.end(); ++it) {
+            in_key.push_back(it->first);
+            in_key.push_back(it->second);
+        }
+        for (std::vector<std::pair<int, int>>::iterator it = outgoing_pair_label_vec.begin(); it != outgoing_pair_label_vec.end(); ++it) {
+            in_key.push_back(it->first);
+            in_key.push_back(it->second);
+        }
+    } else {//only takes incoming and outgoing vertex labels
+        for(int i=0; i < vertex.num_inedges(); i++) {
+            in_key.push_back(in_label(i));
+        }
+        for (int i=0; i < vertex.num_outedges(); i++) {
+            out_key.push_back(out_label(i));
+        }
+        sort_neighbor_labels(in_key, 1);
+        sort_neighbor_labels(out_key, 1);
+    }
+}
+
+//Key policies of the relabel variants (relabel_variant in kernelmaps.hpp)
+//Keys::relabel(vertex, self_label, edge_types, in_label, out_label, lookup, scratch) returns the new label of a vertex in an update phase after
+//the first one. in_label and out_label are as in build_neighbor_keys, edge_types is set in the second update phase (the only one
+//that takes edge types) and lookup(kind, labels, len) gives the id of a label tuple. The keys are built in the scratch arena of the
+//update thread.
+//The vertex programs take the policy as a template argument, so that every variant has its own update without branching on it
+
+//direction and edge aware (the default): the keys of build_neighbor_keys, then the combined key of the two
+struct edge_aware_keys {
+    template <typename InLabel, typename OutLabel, typename Lookup>
+    static int relabel(graphchi_vertex<VertexDataType, EdgeDataType> &vertex, int self_label, bool edge_types, InLabel in_label, OutLabel out_label, Lookup lookup,
+                       scratch_arena &scratch) {
+        std::vector<int> &in_key = scratch.get<int>(SCRATCH_IN_KEY);
+        std::vector<int> &out_key = scratch.get<int>(SCRATCH_OUT_KEY);
+        build_neighbor_keys(vertex, self_label, edge_types, in_label, out_label, in_key, out_key, scratch);
+        int combined_key[2];
+        combined_key[0] = lookup(RELABEL_NEIGHBOR, in_key.data(), in_key.size());
+        combined_key[1] = lookup(RELABEL_NEIGHBOR, out_key.data(), out_key.size());
+        return lookup(RELABEL_COMBINED, combined_key, 2);
+    }
+};
+
+//direction aware: a key of the incoming and one of the outgoing neighbor labels, then the combined key of the two
+//With TakeEdgeLabel the edge types are sorted in with the neighbor labels in the second update phase
+template <bool TakeEdgeLabel>
+struct directed_keys {
+    template <typename InLabel, typename OutLabel, typename Lookup>
+    static int relabel(graphchi_vertex<VertexDataType, EdgeDataType> &vertex, int self_label, bool edge_types, InLabel in_label, OutLabel out_label, Lookup lookup,
+                       scratch_arena &scratch) {
+        bool with_edges = TakeEdgeLabel && edge_types;
+        std::vector<int> &in_key = scratch.get<int>(SCRATCH_IN_KEY);
+        std::vector<int> &out_key = scratch.get<int>(SCRATCH_OUT_KEY);
+        in_key.push_back(self_label);
+        out_key.push_back(self_label);
+        for (int i = 0; i < vertex.num_inedges(); i++) {
+            in_key.push_back(in_label(i));
+            if (with_edges)
+                in_key.push_back(vertex.inedge(i)->get_data().edge);
+        }
+        for (int i = 0; i < vertex.num_outedges(); i++) {
+            out_key.push_back(out_label(i));
+            if (with_edges)
+                out_key.push_back(vertex.outedge(i)->get_data().edge);
+        }
+        sort_neighbor_labels(in_key, 1);
+        sort_neighbor_labels(out_key, 1);
+        int combined_key[2];
+        combined_key[0] = lookup(RELABEL_NEIGHBOR, in_key.data(), in_key.size());
+        combined_key[1] = lookup(RELABEL_NEIGHBOR, out_key.data(), out_key.size());
+        return lookup(RELABEL_COMBINED, combined_key, 2);
+    }
+};
+
+//directionless: a single key of the labels of all neighbors, incoming or outgoing
+//With TakeEdgeLabel the edge types are sorted in with the neighbor labels in the second update phase
+template <bool TakeEdgeLabel>
+struct directionless_keys {
+    template <typename InLabel, typename OutLabel, typename Lookup>
+    static int relabel(graphchi_vertex<VertexDataType, EdgeDataType> &vertex, int self_label, bool edge_types, InLabel in_label, OutLabel out_label, Lookup lookup,
+                       scratch_arena &scratch) {
+        bool with_edges = TakeEdgeLabel && edge_types;
+        std::vector<int> &key = scratch.get<int>(SCRATCH_IN_KEY);
+        key.push_back(self_label);
+        for (int i = 0; i < vertex.num_inedges(); i++) {
+            key.push_back(in_label(i));
+            if (with_edges)
+                key.push_back(vertex.inedge(i)->get_data().edge);
+        }
+        for (int i = 0; i < vertex.num_outedges(); i++) {
+            key.push_back(out_label(i));
+            if (with_edges)
+                key.push_back(vertex.outedge(i)->get_data().edge);
+        }
+        sort_neighbor_labels(key, 1);
+        return lookup(RELABEL_NEIGHBOR, key.data(), key.size());
+    }
+};
+
+//calls f.template run<Keys>() with the key policy of the variant
+template <typename F>
+void with_relabel_keys(int variant, F& f) {
+    switch (variant) {
+        case RELABEL_EDGE_AWARE:
+            f.template run<edge_aware_keys>();
+            break;
+        case RELABEL_DIRECTED:
+            f.template run<directed_keys<false>>();
+            break;
+        case RELABEL_DIRECTED_EDGE_LABELS:
+            f.template run<directed_keys<true>>();
+            break;
+        case RELABEL_DIRECTIONLESS:
+            f.template run<directionless_keys<false>>();
+            break;
+        case RELABEL_DIRECTIONLESS_EDGE_LABELS:
+            f.template run<directionless_keys<true>>();
+            break;
+        default:
+            logstream(LOG_FATAL) << "Unknown relabel variant " << variant << std::endl;
+            assert(false);
+    }
+}
+
+//relabel <edge_aware|directed|directionless> and take_edge_label <0|1> (directed and directionless only; edge_aware always takes them)
+int parse_relabel_variant(const std::string& name, bool take_edge_label) {
+    if (name == "edge_aware")
+        return RELABEL_EDGE_AWARE;
+    if (name == "directed")
+        return take_edge_label ? RELABEL_DIRECTED_EDGE_LABELS : RELABEL_DIRECTED;
+    if (name == "directionless")
+        return take_edge_label ? RELABEL_DIRECTIONLESS_EDGE_LABELS : RELABEL_DIRECTIONLESS;
+    logstream(LOG_FATAL) << "Unknown relabel variant " << name << " (edge_aware, directed or directionless)" << std::endl;
+    assert(false);
+    return RELABEL_EDGE_AWARE;
+}
+
+//Where the update phases of the relabel programs keep the labels they broadcast on the edges
+//Double-buffered (the default): an update phase (round) runs in every iteration. Round r writes the old_ fields of the edges if r
+//is even and the new_ fields if r is odd, and reads the labels of round r - 1 from the other ones, which no vertex writes in round
+//r (as PairContainer::oldval/set_newval in graphchi_types.hpp). Round 0 writes old_, so that the types parsed into new_ are intact
+//while initial_vertex_type reads them
+//Swap phase (swap_phase 1, the original layout): update phases run in even iterations, write new_ and read old_, and every odd
+//iteration copies new_ to old_ on every edge (swap_edge_labels), so a round costs two passes over the shards
+struct edge_label_buffers {
+    bool swap_phase = false;
+
+    //the round of an iteration, -1 for a swap phase
+    int round(int iteration) const {
+        if (!this->swap_phase)
+            return iteration;
+        return iteration % 2 == 1 ? -1 : iteration / 2;
+    }
+
+    //iterations the engine runs for the rounds of niters iterations of the swap phase layout ((niters + 1) / 2 rounds, as the
+    //models and incremental relabeling count them)
+    int iterations(int niters) const {
+        return this->swap_phase ? niters : (niters + 1) / 2;
+    }
+
+    bool writes_old(int round) const {
+        return !this->swap_phase && round % 2 == 0;
+    }
+
+    bool reads_old(int round) const {
+        return this->swap_phase || round % 2 == 1;
+    }
+};
+
+//swap_phase <0|1>
+edge_label_buffers relabel_edge_buffers() {
+    edge_label_buffers buffers;
+    buffers.swap_phase = get_option_int("swap_phase", 0) != 0;
+    return buffers;
+}
+
+//Label counts of the rounds of a relabel run, and its convergence. A round only splits the label classes of the round before
+//(every key starts with the label of the vertex itself), so once a round has as many distinct labels as the one before, every
+//later round has the same classes under other names. With enabled the run ends there (gcontext.set_last_iteration) instead of
+//running every round of niters, which is then a cap. Runs that end at different rounds have count arrays with the labels of
+//different rounds, so only the learning stage stops early, to find the round every graph is then relabeled to (learn_profile)
+struct relabel_convergence {
+    bool enabled = false;
+    std::vector<size_t> round_labels;//distinct labels of every round run so far
+
+    //record the distinct labels of the round that just ended; returns true if the run converged
+    bool end_round(int round, size_t labels) {
+        logstream(LOG_INFO) << "Relabel round " << round << ": " << labels << " distinct labels" << std::endl;
+        this->round_labels.push_back(labels);
+        return this->enabled && round > 0 && labels <= this->round_labels[round - 1];
+    }
+
+    //end the run if the round of this iteration converged; labels are the distinct labels of the round
+    void after_round(graphchi_context &gcontext, int iteration, int round, size_t labels) {
+        if (this->end_round(round, labels) && iteration + 1 < gcontext.num_iterations) {
+            logstream(LOG_INFO) << "Labels converged after round " << round << ", stopping at iteration " << iteration << std::endl;
+            gcontext.set_last_iteration(iteration);
+        }
+    }
+
+    //relabel_rounds (the rounds run, summed over runs), relabel_converged (runs that stopped early) and relabel_round_labels
+    //(distinct labels of every round, summed over runs)
+    void report(metrics &m, int max_rounds) const {
+        m.add("relabel_rounds", (double)this->round_labels.size());
+        if ((int)this->round_labels.size() < max_rounds)
+            m.add("relabel_converged", 1.0);
+        for (size_t r = 0; r < this->round_labels.size(); r++)
+            m.add_vector_entry("relabel_round_labels", r, (double)this->round_labels[r]);
+    }
+};
+
+//The new label of a vertex in the given round (> 0), with the neighbor labels of the previous round taken from the edges (the src
+//label of in edges, the dst label of out edges, in the fields that round wrote). Edge types are taken in round 1
+template <typename Keys, typename Lookup>
+int relabel_from_edges(graphchi_vertex<VertexDataType, EdgeDataType> &vertex, int round, const edge_label_buffers &buffers,
+                       graphchi_context &gcontext, Lookup lookup) {
+    if (buffers.reads_old(round))
+        return Keys::relabel(vertex, vertex.get_data(), round == 1,
+                             [&vertex](int i) { return vertex.inedge(i)->get_data().old_src; },
+                             [&vertex](int i) { return vertex.outedge(i)->get_data().old_dst; },
+                             lookup, gcontext.scratch());
+    return Keys::relabel(vertex, vertex.get_data(), round == 1,
+                         [&vertex](int i) { return vertex.inedge(i)->get_data().new_src; },
+                         [&vertex](int i) { return vertex.outedge(i)->get_data().new_dst; },
+                         lookup, gcontext.scratch());
+}
+
+//swap phase in odd-numbered iterations (swap_phase 1 only)
+void swap_edge_labels(graphchi_vertex<VertexDataType, EdgeDataType> &vertex) {
+    for(int i=0; i < vertex.num_inedges(); i++) {
+        graphchi_edge<EdgeDataType> * in_edge = vertex.inedge(i);
+        type_label in_type = in_edge->get_data();
+        in_type.old_dst = in_type.new_dst;
+        in_edge->set_data(in_type);
+    }
+    for (int i=0; i < vertex.num_outedges(); i++) {
+        graphchi_edge<EdgeDataType> * out_edge = vertex.outedge(i);
+        type_label out_type = out_edge->get_data();
+        out_type.old_src = out_type.new_src;
+        out_edge->set_data(out_type);
+    }
+}
+
+// broadcast new label to neighbors by writing the value to the edges
+// write to the src_type if the vertex is the source vertex of the incident edge
+// write to the dst_type if the vertex is the destination vertex of the incident edge
+// (the old_ fields instead of the new_ ones if to_old, see edge_label_buffers)
+void broadcast_label(graphchi_vertex<VertexDataType, EdgeDataType> &vertex, bool to_old) {
+    int label = vertex.get_data();
+    for(int i=0; i < vertex.num_inedges(); i++) {
+        graphchi_edge<EdgeDataType> * in_edge = vertex.inedge(i);
+        type_label in_type = in_edge->get_data();
+        (to_old ? in_type.old_dst : in_type.new_dst) = label;
+        in_edge->set_data(in_type);
+    }
+    for (int i=0; i < vertex.num_outedges(); i++) {
+        graphchi_edge<EdgeDataType> * out_edge = vertex.outedge(i);
+        type_label out_type = out_edge->get_data();
+        (to_old ? out_type.old_src : out_type.new_src) = label;
+        out_edge->set_data(out_type);
+    }
+}
+
+//a histogram estimated by relabel_sample, with the bound on its L1 distance from the exact one (2 bounds nothing)
+struct sample_estimate {
+    long vertices;
+    long roots;
+    double l1;
+
+    double hellinger() const {
+        return sqrt(this->l1 / 2);
+    }
+};
+
+//Sampled relabeling (sample <fraction> below 1), for graphs too large to relabel whole: the label histogram of a graph is
+//estimated from the labels of a sample of root vertices (each vertex with probability fraction, by a hash of its id and
+//sample_seed), scaled by the number of vertices over the number of roots. The label of a vertex in round r only depends on its
+//r-hop neighborhood, so only the (rounds - 1)-hop neighborhoods of the roots are relabeled:
+//  iteration 0 labels every vertex with its type (round 0), as the exact programs do, and the roots start growing their
+//  neighborhoods: need of a vertex is the last round whose label of it a root needs (rounds - 1 - its distance to the
+//  nearest root), and every iteration before round 1 pushes it one hop further
+//  round r >= 1 relabels the vertices whose need is at least r, in iteration hops + r - 1
+//The iterations are scheduled on the bitset scheduler (the engine must run with selective scheduling to skip the rest of the
+//graph), and keep the labels of the rounds in the edge fields of the double-buffered layout
+//Error bound: the labels of the roots in a round are a sample of the labels of all vertices in it, and the histogram is the
+//mean of the distributions of the rounds, so its L1 distance from the exact one is at most the mean over the rounds of
+//sqrt(k / n) + sqrt(2 ln(rounds / delta) / n) with probability 1 - delta (n roots, k distinct labels in the round: the
+//multinomial bound of Weissman et al. with a union bound over the rounds). k is only the number the roots show, so the bound
+//is optimistic when most labels are rare. Hellinger distances (calculate_distance2 method 1) are then within sqrt(L1 / 2);
+//KL distances have no such bound
+struct relabel_sample {
+    double fraction = 1.0;
+    uint64_t seed = 0;
+    int hops = 0;//rounds after round 0
+    const graph_union * batch = NULL;//in batch mode the histogram of every graph of the union is estimated on its own
+
+    std::vector<int> need;//-1 for a vertex no root needs past round 0
+    std::vector<std::vector<std::pair<vid_t, int>>> raises;//the needs each update thread (exec_thread_slot) raised in the iteration
+    std::vector<uint8_t> has_edges;
+    std::vector<std::vector<size_t>> round_labels;//distinct labels of the roots of every graph in every round
+    std::vector<vid_t> extra_roots;//sorted; the roots of the graphs the hash picks no root of (pick_roots)
+
+    bool enabled() const {
+        return this->fraction < 1.0;
+    }
+
+    //uniform in [0, 1) by vertex and seed
+    double root_hash(vid_t vertex) const {
+        uint64_t x = vertex ^ (this->seed * 0x9e3779b97f4a7c15ULL);
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return (x >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    bool is_root(vid_t vertex) const {
+        return this->root_hash(vertex) < this->fraction
+            || (!this->extra_roots.empty() && std::binary_search(this->extra_roots.begin(), this->extra_roots.end(), vertex));
+    }
+
+    //every graph with edges gets a root: where the hash picks none of its vertices with edges (likely for small graphs and small
+    //fractions), the one of them with the smallest hash is its root. The vertices with edges are read from the degree file of
+    //the shards, before iteration 0 grows the neighborhoods of the roots
+    void pick_roots(graphchi_context &gcontext) {
+        this->extra_roots.clear();
+        std::string degree_file = filename_degree_data(gcontext.filename);
+        FILE * f = fopen(degree_file.c_str(), "rb");
+        if (f == NULL)
+            logstream(LOG_FATAL) << "Could not read the degrees of the vertices from " << degree_file << std::endl;
+        assert(f != NULL);
+        std::vector<uint8_t> hashed_root(this->graphs(), 0);
+        std::vector<double> smallest(this->graphs(), 2.0);
+        std::vector<vid_t> smallest_vertex(this->graphs(), 0);
+        std::vector<degree> degrees(1 << 16);
+        size_t v = 0;
+        size_t n;
+        while (v < gcontext.nvertices && (n = fread(degrees.data(), sizeof(degree), std::min(degrees.size(), gcontext.nvertices - v), f)) > 0) {
+            for (size_t i = 0; i < n; i++, v++) {
+                if (degrees[i].indegree <= 0 && degrees[i].outdegree <= 0)
+                    continue;
+                int g = this->graph_of((vid_t)v);
+                double hash = this->root_hash((vid_t)v);
+                if (hash < this->fraction)
+                    hashed_root[g] = 1;
+                else if (hash < smallest[g]) {
+                    smallest[g] = hash;
+                    smallest_vertex[g] = (vid_t)v;
+                }
+            }
+        }
+        fclose(f);
+        for (int g = 0; g < this->graphs(); g++) {
+            if (hashed_root[g] || smallest[g] > 1.0)
+                continue;
+            logstream(LOG_INFO) << "Sampled relabeling: the sample has no vertex of graph " << g << ", vertex " << smallest_vertex[g] << " is its root" << std::endl;
+            this->extra_roots.push_back(smallest_vertex[g]);
+        }
+        std::sort(this->extra_roots.begin(), this->extra_roots.end());
+    }
+
+    int graph_of(vid_t vertex) const {
+        return this->batch == NULL ? 0 : this->batch->graph_of(vertex);
+    }
+
+    int graphs() const {
+        return this->batch == NULL ? 1 : this->batch->size();
+    }
+
+    //engine iterations of the given number of rounds
+    int iterations(int rounds) {
+        this->hops = rounds - 1;
+        return this->hops == 0 ? 1 : 2 * this->hops;
+    }
+
+    //round labeled in an iteration, -1 in the iterations between round 0 and round 1 that only grow the neighborhoods
+    int round(int iteration) const {
+        if (iteration == 0)
+            return 0;
+        return iteration < this->hops ? -1 : iteration - this->hops + 1;
+    }
+
+    //schedule the vertices of the iteration (the engine schedules all of them in iteration 0)
+    void before_iteration(int iteration, graphchi_context &gcontext) {
+        this->raises.resize(gcontext.execthreads + 1);
+        if (iteration == 0) {
+            this->need.assign(gcontext.nvertices, -1);
+            this->has_edges.assign(gcontext.nvertices, 0);
+            this->round_labels.assign(this->graphs(), std::vector<size_t>());
+            this->pick_roots(gcontext);
+            return;
+        }
+        int r = this->round(iteration);
+        for (size_t v = 0; v < this->need.size(); v++) {
+            if (r < 0 ? this->need[v] == this->hops - iteration : this->need[v] >= r)
+                gcontext.scheduler->add_task((vid_t)v);
+        }
+    }
+
+    //raise the need of the neighbors of a vertex to need (roots keep theirs). Neighbors are updated by other threads, so the raises
+    //are only recorded here, on the thread of the update, and applied after the iteration (after_iteration): during an iteration a
+    //vertex only reads its own need
+    void grow(graphchi_vertex<VertexDataType, EdgeDataType> &vertex, int need) {
+        std::vector<std::pair<vid_t, int>> &raised = this->raises[exec_thread_slot((int)this->raises.size() - 1)];
+        for (int i = 0; i < vertex.num_edges(); i++) {
+            vid_t neighbor = vertex.edge(i)->vertex_id();
+            if (!this->is_root(neighbor))
+                raised.push_back(std::make_pair(neighbor, need));
+        }
+    }
+
+    //apply the raises of the iteration that just ended
+    void after_iteration() {
+        for (size_t t = 0; t < this->raises.size(); t++) {
+            for (size_t i = 0; i < this->raises[t].size(); i++) {
+                int &need = this->need[this->raises[t][i].first];
+                need = std::max(need, this->raises[t][i].second);
+            }
+            this->raises[t].clear();
+        }
+    }
+
+    //update of a vertex in sampled relabeling, with the key policy and the label lookup of the program; count(vertex, label)
+    //counts the labels of the roots
+    template <typename Keys, typename Lookup, typename Count>
+    void update(graphchi_vertex<VertexDataType, EdgeDataType> &vertex, graphchi_context &gcontext, const edge_label_buffers &buffers,
+                Lookup lookup, Count count) {
+        vid_t id = vertex.id();
+        int iteration = gcontext.iteration;
+        if (iteration == 0) {
+            bool root = this->is_root(id);
+            this->has_edges[id] = 1;
+            if (root)
+                this->need[id] = this->hops;
+            int vertex_type = initial_vertex_type(vertex);
+            int label = lookup(RELABEL_TYPE, &vertex_type, 1);
+            vertex.set_data(label);
+            if (root)
+                count(id, label);
+            broadcast_label(vertex, buffers.writes_old(0));
+            if (root && this->hops > 0)
+                this->grow(vertex, this->hops - 1);
+            return;
+        }
+        int r = this->round(iteration);
+        if (r < 0) {
+            if (this->need[id] == this->hops - iteration)
+                this->grow(vertex, this->need[id] - 1);
+            return;
+        }
+        if (this->need[id] < r)
+            return;
+        int label = relabel_from_edges<Keys>(vertex, r, buffers, gcontext, lookup);
+        vertex.set_data(label);
+        if (this->need[id] == this->hops)
+            count(id, label);
+        if (r < this->hops)
+            broadcast_label(vertex, buffers.writes_old(r));
+    }
+
+    //record the distinct labels of the roots of graph g in the round that just ended
+    void end_round(int g, size_t labels) {
+        this->round_labels[g].push_back(labels);
+    }
+
+    //scale the label map of graph g (the counts of its roots) to the estimated histogram of the graph
+    sample_estimate finish(int g, std::map<int, int> &label_map) const {
+        sample_estimate estimate = {0, 0, 2.0};
+        for (size_t v = 0; v < this->need.size(); v++) {
+            if (!this->has_edges[v] || this->graph_of((vid_t)v) != g)
+                continue;
+            estimate.vertices++;
+            if (this->is_root((vid_t)v))
+                estimate.roots++;
+        }
+        if (estimate.roots == 0) {//pick_roots gives every graph with edges a root
+            logstream(LOG_WARNING) << "Sampled relabeling: graph " << g << " has no edges, its histogram is empty" << std::endl;
+            label_map.clear();
+            return estimate;
+        }
+        double scale = estimate.vertices / (double)estimate.roots;
+        for (std::map<int, int>::iterator itr = label_map.begin(); itr != label_map.end(); itr++)
+            itr->second = std::max(1, (int)(itr->second * scale + 0.5));
+        const std::vector<size_t> &k = this->round_labels[g];
+        double delta = 0.05;
+        estimate.l1 = sqrt(2.0 * log(k.size() / delta) / estimate.roots);
+        for (size_t r = 0; r < k.size(); r++)
+            estimate.l1 += sqrt(k[r] / (double)estimate.roots) / k.size();
+        estimate.l1 = std::min(estimate.l1, 2.0);
+        return estimate;
+    }
+};
+
+void print_sample_estimate(const sample_estimate &estimate, std::ostream &out = std::cout) {
+    out << "Sampled labels of " << estimate.roots << " of " << estimate.vertices << " vertices: L1 distance from the exact distribution <= "
+        << estimate.l1 << ", Hellinger <= " << estimate.hellinger() << " (95% confidence)" << std::endl;
+}
+
+//sample <fraction> (1: every vertex, exact relabeling) and sample_seed <n>
+relabel_sample relabel_run_sample() {
+    relabel_sample sample;
+    sample.fraction = get_option_float("sample", 1.0);
+    sample.seed = get_option_int("sample_seed", 0);
+    if (sample.fraction <= 0.0 || sample.fraction > 1.0)
+        logstream(LOG_FATAL) << "sample is a fraction of the vertices, in (0, 1]" << std::endl;
+    assert(sample.fraction > 0.0 && sample.fraction <= 1.0);
+    return sample;
+}
+
 /**
  * GraphChi programs need to subclass GraphChiProgram<vertex-type, edge-type>
  * class. The main logic is usually in the update function.
+ * Keys is the key policy of the relabel variant (see with_relabel_keys)
  */
+template <typename Keys>
 struct VertexRelabel : public GraphChiProgram<VertexDataType, EdgeDataType> {
-    
+
     //get the singleton kernelMaps
     KernelMaps* km = KernelMaps::get_instance();
-    
-    //locks for sync update
-    std::mutex relabel_map_lock;
-    std::mutex label_map_lock;
+
+    //where the rounds keep their labels on the edges
+    edge_label_buffers buffers;
+
+    relabel_convergence convergence;
+
+    relabel_sample sample;
+
+    //labels counted by each update thread in the current iteration, merged into the label map of the kernelmap after the iteration
+    ThreadLabelCounts label_counts;
+
+    //batch mode: the graph is a graph_union and the labels of graph g are counted in km->label_map(first_label_map + g)
+    const graph_union * batch = NULL;
+    size_t first_label_map = 0;
+    std::vector<ThreadLabelCounts> batch_counts;//one per graph of the union
+
+    void set_batch(const graph_union * batch, size_t first_label_map) {
+        this->batch = batch;
+        this->sample.batch = batch;
+        this->first_label_map = first_label_map;
+        this->batch_counts.resize(batch->size());
+    }
+
+    void count_label(vid_t vertex, int label) {
+        if (this->batch == NULL)
+            this->label_counts.add(label);
+        else
+            this->batch_counts[this->batch->graph_of(vertex)].add(label);
+    }
+
     /**
      *  Vertex update function.
      */
@@ -45,317 +636,129 @@ struct VertexRelabel : public GraphChiProgram<VertexDataType, EdgeDataType> {
             logstream(LOG_INFO) << "Isolated vertex "<<  vertex.id() <<" detected" << std::endl;
             return;
         }
-        //swap phase in odd-numbered iterations
-        if (gcontext.iteration % 2 == 1) {
-            for(int i=0; i < vertex.num_inedges(); i++) {
-                graphchi_edge<EdgeDataType> * in_edge = vertex.inedge(i);
-                type_label in_type = in_edge->get_data();
-                in_type.old_dst = in_type.new_dst;
-                in_edge->set_data(in_type);
-                logstream(LOG_INFO) << "Swapped in edges of " << vertex.id() << " to " << in_type.old_dst << std::endl;
-            }
-            for (int i=0; i < vertex.num_outedges(); i++) {
-                graphchi_edge<EdgeDataType> * out_edge = vertex.outedge(i);
-                type_label out_type = out_edge->get_data();
-                out_type.old_src = out_type.new_src;
-                out_edge->set_data(out_type);
-                logstream(LOG_INFO) << "Swapped out edges of " << vertex.id() << " to " << out_type.old_src << std::endl;
-            }
-        } else {//update phase in even-numbered iterations
-            if (gcontext.iteration == 0) {
+        if (sample.enabled()) {
+            sample.update<Keys>(vertex, gcontext, buffers, [this](int kind, const int * labels, size_t len) {
+                return this->km->insert_relabel(kind, labels, len);
+            }, [this](vid_t id, int label) { this->count_label(id, label); });
+            return;
+        }
+        int round = buffers.round(gcontext.iteration);
+        if (round < 0) {
+            swap_edge_labels(vertex);
+            logstream(LOG_INFO) << "Swapped edges of " << vertex.id() << std::endl;
+        } else {//update phase
+            if (round == 0) {
                 /* On first iteration, initialize vertex (and its edges). This is usually required, because
                  on each run, GraphChi will modify the data files. To start from scratch, it is easiest
                  do initialize the program in code. Alternatively, you can keep a copy of initial data files. */
                 // for each vertex, set its label as its w3c type
-                std::string vertex_label = "";
-                // The value can be obtained from any outedge (from src_type) or in_edge from (dst_type)
-                graphchi_edge<EdgeDataType> * outedge = vertex.random_outedge();
-                //if the node has no outedge, we get a first inedge in the queue
-                if (outedge == NULL) {
-                    graphchi_edge<EdgeDataType> * inedge = vertex.inedge(0);
-                    //get the dst_type from inedge
-                    int vertex_int_label = inedge->get_data().new_dst;
-                    std::string num_string;
-                    std::stringstream out;
-                    out << vertex_int_label;
-                    vertex_label = out.str();
-                } else {
-                    //get the src_type from outedge
-                    int vertex_int_label = outedge->get_data().new_src;
-                    std::string num_string;
-                    std::stringstream out;
-                    out << vertex_int_label;
-                    vertex_label = out.str();
-                }
-                //make sure vertex must have a valid string, not an empty string
-                if (vertex_label != "") {
-                    relabel_map_lock.lock();
-                    int label_map_label = km->insert_relabel(vertex_label);
-                    relabel_map_lock.unlock();
-                    label_map_lock.lock();
-                    km->insert_label(label_map_label);
-                    label_map_lock.unlock();
-                    vertex.set_data(label_map_label);
-                    logstream(LOG_INFO) << "The value of label " << vertex.id() << " is: " << label_map_label << std::endl;
-                } else {
-                    logstream(LOG_FATAL) << "Invalid vertex_label in relabel_map. " << std::endl;
-                    assert (vertex_label != "");
-                }
-            } else {//include edge type during relabeling in the second update phase iteration
-                if (gcontext.iteration == 2) {
-                    std::vector<std::pair<int, int>> incoming_pair_label_vec;
-                    std::vector<std::pair<int, int>> outgoing_pair_label_vec;
-                    for(int i=0; i < vertex.num_inedges(); i++) {
-                        graphchi_edge<EdgeDataType> * in_edge = vertex.inedge(i);
-                        int int_in_type = in_edge->get_data().old_src;
-                        int int_in_edge_type = in_edge->get_data().edge;
-                        std::pair<int, int> pair_label_in (int_in_type, int_in_edge_type);
-                        incoming_pair_label_vec.push_back(pair_label_in);
-                    }
-                    for (int i=0; i < vertex.num_outedges(); i++) {
-                        graphchi_edge<EdgeDataType> * out_edge = vertex.outedge(i);
-                        int int_out_type = out_edge->get_data().old_dst;
-                        int int_out_edge_type = out_edge->get_data().edge;
-                        std::pair<int, int> pair_label_out (int_out_type, int_out_edge_type);
-                        outgoing_pair_label_vec.push_back(pair_label_out);
-                    }
-                    struct {
-                        bool operator()(std::pair<int, int> a, std::pair<int, int> b) {
-                            return a.first < b.first;
-                        }
-                    } comparePair;
-                    
-                    std::sort(incoming_pair_label_vec.begin(), incoming_pair_label_vec.end(), comparePair);
-                    std::sort(outgoing_pair_label_vec.begin(), outgoing_pair_label_vec.end(), comparePair);
-                    
-                    std::string new_incoming_label = "";
-                    std::string first_incoming_num_string;
-                    std::stringstream first_incoming_out;
-                    first_incoming_out << vertex.get_data();
-                    first_incoming_num_string = first_incoming_out.str();
-                    new_incoming_label += first_incoming_num_string;
-                    new_incoming_label += ",";
-                    
-                    for (std::vector<std::pair<int, int>>::iterator it = incoming_pair_label_vec.begin(); it != incoming_pair_label_vec.end(); ++it) {
-                        std::string incoming_num_string_first;
-                        std::stringstream incoming_out_first;
-                        incoming_out_first << it->first;
-                        incoming_num_string_first = incoming_out_first.str();
-                        new_incoming_label += incoming_num_string_first + " ";
-                        std::string incoming_num_string_second;
-                        std::stringstream incoming_out_second;
-                        incoming_out_second << it->second;
-                        incoming_num_string_second = incoming_out_second.str();
-                        new_incoming_label += incoming_num_string_second + " ";
-                    }
-                    
-                    std::string new_outgoing_label = "";
-                    std::string first_outgoing_num_string;
-                    std::stringstream first_outgoing_out;
-                    first_outgoing_out << vertex.get_data();
-                    first_outgoing_num_string = first_outgoing_out.str();
-                    new_outgoing_label += first_outgoing_num_string;
-                    new_outgoing_label += ",";
-                    
-                    for (std::vector<std::pair<int, int>>::iterator it = outgoing_pair_label_vec.begin(); it != outgoing_pair_label_vec.end(); ++it) {
-                        std::string outgoing_num_string_first;
-                        std::stringstream outgoing_out_first;
-                        outgoing_out_first << it->first;
-                        outgoing_num_string_first = outgoing_out_first.str();
-                        new_incoming_label += outgoing_num_string_first + " ";
-                        std::string outgoing_num_string_second;
-                        std::stringstream outgoing_out_second;
-                        outgoing_out_second << it->second;
-                        outgoing_num_string_second = outgoing_out_second.str();
-                        new_incoming_label += outgoing_num_string_second + " ";
-                    }
-                    
-                    relabel_map_lock.lock();
-                    int label_map_label_incoming = km->insert_relabel(new_incoming_label);
-                    int label_map_label_outgoing = km->insert_relabel(new_outgoing_label);
-                    relabel_map_lock.unlock();
-                    
-                    std::string new_combined_label = ""; //label_map_label_incoming,label_map_label_outgoing
-                    std::string incoming_label_in_combined;
-                    std::stringstream incoming_label_in_combined_out;
-                    incoming_label_in_combined_out << label_map_label_incoming;
-                    incoming_label_in_combined = incoming_label_in_combined_out.str();
-                    new_combined_label += incoming_label_in_combined;
-                    new_combined_label += ",";
-                    std::string outgoing_label_in_combined;
-                    std::stringstream outgoing_label_in_combined_out;
-                    outgoing_label_in_combined_out << label_map_label_outgoing;
-                    outgoing_label_in_combined = outgoing_label_in_combined_out.str();
-                    new_combined_label += outgoing_label_in_combined;
-                    
-                    relabel_map_lock.lock();
-                    int label_map_label_combined = km->insert_relabel(new_combined_label);
-                    relabel_map_lock.unlock();
-                    
-                    label_map_lock.lock();
-                    km->insert_label(label_map_label_combined);
-                    label_map_lock.unlock();
-                    vertex.set_data(label_map_label_combined);
-                    logstream(LOG_INFO) << "The value of label " << vertex.id() << " is: " << label_map_label_combined << std::endl;
-                } else {//only takes incoming and outgoing vertex labels
-                    std::vector<int> incoming_label_vec;
-                    std::vector<int> outgoing_label_vec;
-                    for(int i=0; i < vertex.num_inedges(); i++) {
-                        graphchi_edge<EdgeDataType> * in_edge = vertex.inedge(i);
-                        int int_in_type = in_edge->get_data().old_src;
-                        incoming_label_vec.push_back(int_in_type);
-                        logstream(LOG_INFO) << "Vertex " << vertex.id() << " getting " << int_in_type << " from in edges" << std::endl;
-                    }
-                    for (int i=0; i < vertex.num_outedges(); i++) {
-                        graphchi_edge<EdgeDataType> * out_edge = vertex.outedge(i);
-                        int int_out_type = out_edge->get_data().old_dst;
-                        outgoing_label_vec.push_back(int_out_type);
-                        logstream(LOG_INFO) << "Vertex " << vertex.id() << " getting " << int_out_type << " from out edges" << std::endl;
-                    }
-                    std::sort(incoming_label_vec.begin(), incoming_label_vec.end());
-                    std::sort(outgoing_label_vec.begin(), outgoing_label_vec.end());
-                    
-                    int self_label = vertex.get_data();
-                    incoming_label_vec.push_back(self_label);
-                    outgoing_label_vec.push_back(self_label);
-                    
-                    std::string new_incoming_label = "";
-                    std::string first_incoming_num_string;
-                    std::stringstream first_incoming_out;
-                    first_incoming_out << *(incoming_label_vec.end() - 1);
-                    first_incoming_num_string = first_incoming_out.str();
-                    new_incoming_label += first_incoming_num_string;
-                    new_incoming_label += ",";
-                    
-                    for (std::vector<int>::iterator it = incoming_label_vec.begin(); it != incoming_label_vec.end() - 1; ++it) {
-                        std::string incoming_num_string;
-                        std::stringstream incoming_out;
-                        incoming_out << *it;
-                        incoming_num_string = incoming_out.str();
-                        new_incoming_label += incoming_num_string + " ";
-                    }
-                    
-                    std::string new_outgoing_label = "";
-                    std::string first_outgoing_num_string;
-                    std::stringstream first_outgoing_out;
-                    first_outgoing_out << *(outgoing_label_vec.end() - 1);
-                    first_outgoing_num_string = first_outgoing_out.str();
-                    new_outgoing_label += first_outgoing_num_string;
-                    new_outgoing_label += ",";
-                    
-                    for (std::vector<int>::iterator it = outgoing_label_vec.begin(); it != outgoing_label_vec.end() - 1; ++it) {
-                        std::string outgoing_num_string;
-                        std::stringstream outgoing_out;
-                        outgoing_out << *it;
-                        outgoing_num_string = outgoing_out.str();
-                        new_outgoing_label += outgoing_num_string + " ";
-                    }
-                    
-                    relabel_map_lock.lock();
-                    int label_map_label_incoming = km->insert_relabel(new_incoming_label);
-                    int label_map_label_outgoing = km->insert_relabel(new_outgoing_label);
-                    relabel_map_lock.unlock();
-                    
-                    std::string new_combined_label = ""; //label_map_label_incoming,label_map_label_outgoing
-                    std::string incoming_label_in_combined;
-                    std::stringstream incoming_label_in_combined_out;
-                    incoming_label_in_combined_out << label_map_label_incoming;
-                    incoming_label_in_combined = incoming_label_in_combined_out.str();
-                    new_combined_label += incoming_label_in_combined;
-                    new_combined_label += ",";
-                    std::string outgoing_label_in_combined;
-                    std::stringstream outgoing_label_in_combined_out;
-                    outgoing_label_in_combined_out << label_map_label_outgoing;
-                    outgoing_label_in_combined = outgoing_label_in_combined_out.str();
-                    new_combined_label += outgoing_label_in_combined;
-                    
-                    relabel_map_lock.lock();
-                    int label_map_label_combined = km->insert_relabel(new_combined_label);
-                    relabel_map_lock.unlock();
-                    
-                    label_map_lock.lock();
-                    km->insert_label(label_map_label_combined);
-                    label_map_lock.unlock();
-                    vertex.set_data(label_map_label_combined);
-                    logstream(LOG_INFO) << "The value of label " << vertex.id() << " is: " << label_map_label_combined << std::endl;
-                }
-            }
-            
-            // broadcast new label to neighbors by writing the value to the edges
-            // write to the src_type if the vertex is the source vertex of the incident edge
-            // write to the dst_type if the vertex is the destination vertex of the incident edge
-            int label = vertex.get_data();
-            if (gcontext.iteration == 0) {
-                for(int i=0; i < vertex.num_inedges(); i++) {
-                    graphchi_edge<EdgeDataType> * in_edge = vertex.inedge(i);
-                    type_label in_type = in_edge->get_data();
-                    in_type.new_dst = label;
-                    in_edge->set_data(in_type);
-                }
-                for (int i=0; i < vertex.num_outedges(); i++) {
-                    graphchi_edge<EdgeDataType> * out_edge = vertex.outedge(i);
-                    type_label out_type = out_edge->get_data();
-                    out_type.new_src = label;
-                    out_edge->set_data(out_type);
-                }
-            } else {
-                for(int i=0; i < vertex.num_inedges(); i++) {
-                    graphchi_edge<EdgeDataType> * in_edge = vertex.inedge(i);
-                    type_label in_type = in_edge->get_data();
-                    in_type.new_dst = label;
-                    in_edge->set_data(in_type);
-                    logstream(LOG_INFO) << "Updated in edges of " << vertex.id() << " to " << in_type.old_dst << std::endl;
-                }
-                for (int i=0; i < vertex.num_outedges(); i++) {
-                    graphchi_edge<EdgeDataType> * out_edge = vertex.outedge(i);
-                    type_label out_type = out_edge->get_data();
-                    out_type.new_src = label;
-                    out_edge->set_data(out_type);
-                    logstream(LOG_INFO) << "Updated out edges of " << vertex.id() << " to " << out_type.old_src << std::endl;
-                }
+                int vertex_type = initial_vertex_type(vertex);
+                int label_map_label = km->insert_relabel(RELABEL_TYPE, &vertex_type, 1);
+                count_label(vertex.id(), label_map_label);
+                vertex.set_data(label_map_label);
+                logstream(LOG_INFO) << "The value of label " << vertex.id() << " is: " << label_map_label << std::endl;
+            } else {//include edge type during relabeling in the second update phase (round 1)
+                int label_map_label_combined = relabel_from_edges<Keys>(vertex, round, buffers, gcontext, [this](int kind, const int * labels, size_t len) {
+                    return this->km->insert_relabel(kind, labels, len);
+                });
+
+                count_label(vertex.id(), label_map_label_combined);
+                vertex.set_data(label_map_label_combined);
+                logstream(LOG_INFO) << "The value of label " << vertex.id() << " is: " << label_map_label_combined << std::endl;
             }
+
+            broadcast_label(vertex, buffers.writes_old(round));
             /* Scheduler myself for next iteration */
             //gcontext.scheduler->add_task(vertex.id());
         }
     }
-    
+
     /**
      * Called before an iteration starts.
      */
     void before_iteration(int iteration, graphchi_context &gcontext) {
+        label_counts.reset(gcontext.execthreads);
+        for (size_t g = 0; g < batch_counts.size(); g++)
+            batch_counts[g].reset(gcontext.execthreads);
+        if (sample.enabled())
+            sample.before_iteration(iteration, gcontext);
     }
-    
+
     /**
      * Called after an iteration has finished.
      */
-    //For debugging purpose:
     void after_iteration(int iteration, graphchi_context &gcontext) {
+        if (sample.enabled()) {
+            sample.after_iteration();
+            if (sample.round(iteration) >= 0) {
+                for (int g = 0; g < sample.graphs(); g++) {
+                    std::unordered_set<int> labels;
+                    (batch == NULL ? label_counts : batch_counts[g]).collect_labels(labels);
+                    sample.end_round(g, labels.size());
+                }
+            }
+        } else if (buffers.round(iteration) >= 0) {
+            int round = buffers.round(iteration);
+            //in batch mode the labels of all graphs of the union: a round that splits no class of the union splits none of any graph
+            std::unordered_set<int> labels;
+            label_counts.collect_labels(labels);
+            for (size_t g = 0; g < batch_counts.size(); g++)
+                batch_counts[g].collect_labels(labels);
+            convergence.after_round(gcontext, iteration, round, labels.size());
+        }
+        if (batch == NULL)
+            label_counts.merge_into(km->last_label_map());
+        for (size_t g = 0; g < batch_counts.size(); g++)
+            batch_counts[g].merge_into(km->label_map(first_label_map + g));
     }
-    
+
     /**
      * Called before an execution interval is started.
      */
     void before_exec_interval(vid_t window_st, vid_t window_en, graphchi_context &gcontext) {
     }
-    
+
     /**
      * Called after an execution interval has finished.
      */
     void after_exec_interval(vid_t window_st, vid_t window_en, graphchi_context &gcontext) {
     }
-    
+
 };
 
+template <typename Keys>
 struct VertexRelabelDetection : public GraphChiProgram<VertexDataType, EdgeDataType> {
-    
+
     //get the singleton kernelMaps
     KernelMaps* km = KernelMaps::get_instance();
-    //get the relabel map of the kernelmap
-    std::map<std::string, int> reference_map = km->get_relabel_map();
-    
-    //locks for sync update
-    std::mutex relabel_map_lock;
-    std::mutex label_map_lock;
+
+    //where the rounds keep their labels on the edges
+    edge_label_buffers buffers;
+
+    relabel_convergence convergence;
+
+    relabel_sample sample;
+
+    //labels that are not in the relabel map of the kernelmap get ids past the learned ones
+    //they never show up in the count array, but they still need to be consistent during the run
+    ShardedLabelTable unknown_table;
+    std::atomic<int> next_unknown_label{km->get_counter() + 1};
+
+    //labels counted by each update thread in the current iteration, merged into label_map after the iteration
+    ThreadLabelCounts label_counts;
+
+    //histogram of the monitored graph, owned by the caller (one per detection job)
+    std::map<int, int> * label_map = NULL;
+
+    //look up a label tuple in the relabel map of the learning stage without modifying it
+    int lookup_relabel(int kind, const int * labels, size_t len) {
+        int label = km->find_relabel(kind, labels, len);
+        if (label >= 0)
+            return label;
+        bool inserted;
+        return unknown_table.insert(kind, labels, len, next_unknown_label, inserted);
+    }
+
     /**
      *  Vertex update function.
      */
@@ -366,397 +769,158 @@ struct VertexRelabelDetection : public GraphChiProgram<VertexDataType, EdgeDataT
             logstream(LOG_INFO) << "Isolated vertex "<<  vertex.id() <<" detected" << std::endl;
             return;
         }
-        //swap phase in odd-numbered iterations
-        if (gcontext.iteration % 2 == 1) {
-            for(int i=0; i < vertex.num_inedges(); i++) {
-                graphchi_edge<EdgeDataType> * in_edge = vertex.inedge(i);
-                type_label in_type = in_edge->get_data();
-                in_type.old_dst = in_type.new_dst;
-                in_edge->set_data(in_type);
-                //logstream(LOG_INFO) << "Swapped in edges of " << vertex.id() << " to " << in_type.old_dst << std::endl;
-            }
-            for (int i=0; i < vertex.num_outedges(); i++) {
-                graphchi_edge<EdgeDataType> * out_edge = vertex.outedge(i);
-                type_label out_type = out_edge->get_data();
-                out_type.old_src = out_type.new_src;
-                out_edge->set_data(out_type);
-                //logstream(LOG_INFO) << "Swapped out edges of " << vertex.id() << " to " << out_type.old_src << std::endl;
-            }
-        } else {//update phase in even-numbered iterations
-            if (gcontext.iteration == 0) {
+        if (sample.enabled()) {
+            sample.update<Keys>(vertex, gcontext, buffers, [this](int kind, const int * labels, size_t len) {
+                return this->lookup_relabel(kind, labels, len);
+            }, [this](vid_t id, int label) { this->label_counts.add(label); });
+            return;
+        }
+        int round = buffers.round(gcontext.iteration);
+        if (round < 0) {
+            swap_edge_labels(vertex);
+        } else {//update phase
+            if (round == 0) {
                 /* On first iteration, initialize vertex (and its edges). This is usually required, because
                  on each run, GraphChi will modify the data files. To start from scratch, it is easiest
                  do initialize the program in code. Alternatively, you can keep a copy of initial data files. */
                 // for each vertex, set its label as its w3c type
-                std::string vertex_label = "";
-                // The value can be obtained from any outedge (from src_type) or in_edge from (dst_type)
-                graphchi_edge<EdgeDataType> * outedge = vertex.random_outedge();
-                //if the node has no outedge, we get a first inedge in the queue
-                if (outedge == NULL) {
-                    graphchi_edge<EdgeDataType> * inedge = vertex.inedge(0);
-                    //get the dst_type from inedge
-                    int vertex_int_label = inedge->get_data().new_dst;
-                    std::string num_string;
-                    std::stringstream out;
-                    out << vertex_int_label;
-                    vertex_label = out.str();
-                } else {
-                    //get the src_type from outedge
-                    int vertex_int_label = outedge->get_data().new_src;
-                    std::string num_string;
-                    std::stringstream out;
-                    out << vertex_int_label;
-                    vertex_label = out.str();
-                }
-                //make sure vertex must have a valid string, not an empty string
-                if (vertex_label != "") {
-                    relabel_map_lock.lock();
-                    
-                    int label_map_label;
-                    std::pair<std::map<std::string, int>::iterator, bool> rst_temp;
-                    rst_temp = reference_map.insert(std::pair<std::string, int>(vertex_label, reference_map.size()));
-                    if (rst_temp.second == false) {
-                        //logstream(LOG_INFO) << "Label " + vertex_label + " is already in the map." << std::endl;
-                        label_map_label = rst_temp.first->second;
-                    } else {
-                        label_map_label = reference_map.size();
-                    }
-                    
-                    relabel_map_lock.unlock();
-                    label_map_lock.lock();
-                    
-                    std::pair<std::map<int, int>::iterator, bool> rst_temp2;
-                    rst_temp2 = monitored.label_map.insert(std::pair<int, int>(label_map_label, 1));
-                    if (rst_temp2.second == false) {
-                        //logstream(LOG_INFO) << "Label is already in the map. Updating the value..." << std::endl;
-                        rst_temp2.first->second++;
-                    }
-                    
-                    label_map_lock.unlock();
-                    vertex.set_data(label_map_label);
-                    //logstream(LOG_INFO) << "The value of label " << vertex.id() << " is: " << label_map_label << std::endl;
-                } else {
-                    logstream(LOG_FATAL) << "Invalid vertex_label in relabel_map. " << std::endl;
-                    assert (vertex_label != "");
-                }
-            } else {//include edge type during relabeling in the second update phase iteration
-                if (gcontext.iteration == 2) {
-                    std::vector<std::pair<int, int>> incoming_pair_label_vec;
-                    std::vector<std::pair<int, int>> outgoing_pair_label_vec;
-                    for(int i=0; i < vertex.num_inedges(); i++) {
-                        graphchi_edge<EdgeDataType> * in_edge = vertex.inedge(i);
-                        int int_in_type = in_edge->get_data().old_src;
-                        int int_in_edge_type = in_edge->get_data().edge;
-                        std::pair<int, int> pair_label_in (int_in_type, int_in_edge_type);
-                        incoming_pair_label_vec.push_back(pair_label_in);
-                    }
-                    for (int i=0; i < vertex.num_outedges(); i++) {
-                        graphchi_edge<EdgeDataType> * out_edge = vertex.outedge(i);
-                        int int_out_type = out_edge->get_data().old_dst;
-                        int int_out_edge_type = out_edge->get_data().edge;
-                        std::pair<int, int> pair_label_out (int_out_type, int_out_edge_type);
-                        outgoing_pair_label_vec.push_back(pair_label_out);
-                    }
-                    struct {
-                        bool operator()(std::pair<int, int> a, std::pair<int, int> b) {
-                            return a.first < b.first;
-                        }
-                    } comparePair;
-                    
-                    std::sort(incoming_pair_label_vec.begin(), incoming_pair_label_vec.end(), comparePair);
-                    std::sort(outgoing_pair_label_vec.begin(), outgoing_pair_label_vec.end(), comparePair);
-                    
-                    std::string new_incoming_label = "";
-                    std::string first_incoming_num_string;
-                    std::stringstream first_incoming_out;
-                    first_incoming_out << vertex.get_data();
-                    first_incoming_num_string = first_incoming_out.str();
-                    new_incoming_label += first_incoming_num_string;
-                    new_incoming_label += ",";
-                    
-                    for (std::vector<std::pair<int, int>>::iterator it = incoming_pair_label_vec.begin(); it != incoming_pair_label_vec.end(); ++it) {
-                        std::string incoming_num_string_first;
-                        std::stringstream incoming_out_first;
-                        incoming_out_first << it->first;
-                        incoming_num_string_first = incoming_out_first.str();
-                        new_incoming_label += incoming_num_string_first + " ";
-                        std::string incoming_num_string_second;
-                        std::stringstream incoming_out_second;
-                        incoming_out_second << it->second;
-                        incoming_num_string_second = incoming_out_second.str();
-                        new_incoming_label += incoming_num_string_second + " ";
-                    }
-                    
-                    std::string new_outgoing_label = "";
-                    std::string first_outgoing_num_string;
-                    std::stringstream first_outgoing_out;
-                    first_outgoing_out << vertex.get_data();
-                    first_outgoing_num_string = first_outgoing_out.str();
-                    new_outgoing_label += first_outgoing_num_string;
-                    new_outgoing_label += ",";
-                    
-                    for (std::vector<std::pair<int, int>>::iterator it = outgoing_pair_label_vec.begin(); it != outgoing_pair_label_vec.end(); ++it) {
-                        std::string outgoing_num_string_first;
-                        std::stringstream outgoing_out_first;
-                        outgoing_out_first << it->first;
-                        outgoing_num_string_first = outgoing_out_first.str();
-                        new_incoming_label += outgoing_num_string_first + " ";
-                        std::string outgoing_num_string_second;
-                        std::stringstream outgoing_out_second;
-                        outgoing_out_second << it->second;
-                        outgoing_num_string_second = outgoing_out_second.str();
-                        new_incoming_label += outgoing_num_string_second + " ";
-                    }
-                    
-                    relabel_map_lock.lock();
-                    
-                    
-                    int label_map_label_incoming;
-                    int label_map_label_outgoing;
-                    
-                    std::pair<std::map<std::string, int>::iterator, bool> rst_temp_incoming;
-                    rst_temp_incoming = reference_map.insert(std::pair<std::string, int>(new_incoming_label, reference_map.size()));
-                    if (rst_temp_incoming.second == false) {
-                        //logstream(LOG_INFO) << "Label " + new_incoming_label + " is already in the map." << std::endl;
-                        label_map_label_incoming = rst_temp_incoming.first->second;
-                    } else {
-                        label_map_label_incoming = reference_map.size();
-                    }
-                    
-                    std::pair<std::map<std::string, int>::iterator, bool> rst_temp_outgoing;
-                    rst_temp_outgoing = reference_map.insert(std::pair<std::string, int>(new_outgoing_label, reference_map.size()));
-                    if (rst_temp_outgoing.second == false) {
-                        //logstream(LOG_INFO) << "Label " + new_outgoing_label + " is already in the map." << std::endl;
-                        label_map_label_outgoing = rst_temp_outgoing.first->second;
-                    } else {
-                        label_map_label_outgoing = reference_map.size();
-                    }
-                    
-                    
-                    relabel_map_lock.unlock();
-                    
-                    std::string new_combined_label = ""; //label_map_label_incoming,label_map_label_outgoing
-                    std::string incoming_label_in_combined;
-                    std::stringstream incoming_label_in_combined_out;
-                    incoming_label_in_combined_out << label_map_label_incoming;
-                    incoming_label_in_combined = incoming_label_in_combined_out.str();
-                    new_combined_label += incoming_label_in_combined;
-                    new_combined_label += ",";
-                    std::string outgoing_label_in_combined;
-                    std::stringstream outgoing_label_in_combined_out;
-                    outgoing_label_in_combined_out << label_map_label_outgoing;
-                    outgoing_label_in_combined = outgoing_label_in_combined_out.str();
-                    new_combined_label += outgoing_label_in_combined;
-                    
-                    relabel_map_lock.lock();
-                    
-                    int label_map_label_combined;
-                    std::pair<std::map<std::string, int>::iterator, bool> rst_temp_combined;
-                    rst_temp_combined = reference_map.insert(std::pair<std::string, int>(new_combined_label, reference_map.size()));
-                    if (rst_temp_combined.second == false) {
-                        //logstream(LOG_INFO) << "Label " + new_combined_label + " is already in the map." << std::endl;
-                        label_map_label_combined = rst_temp_combined.first->second;
-                    } else {
-                        label_map_label_combined = reference_map.size();
-                    }
-                    
-                    
-                    relabel_map_lock.unlock();
-                    
-                    label_map_lock.lock();
-                    
-                    std::pair<std::map<int, int>::iterator, bool> rst_insert;
-                    rst_insert = monitored.label_map.insert(std::pair<int, int>(label_map_label_combined, 1));
-                    if (rst_insert.second == false) {
-                        //logstream(LOG_INFO) << "Label is already in the map. Updating the value..." << std::endl;
-                        rst_insert.first->second++;
-                    }
-                    
-                    label_map_lock.unlock();
-                    vertex.set_data(label_map_label_combined);
-                    //logstream(LOG_INFO) << "The value of label " << vertex.id() << " is: " << label_map_label_combined << std::endl;
-                } else {//only takes incoming and outgoing vertex labels
-                    std::vector<int> incoming_label_vec;
-                    std::vector<int> outgoing_label_vec;
-                    for(int i=0; i < vertex.num_inedges(); i++) {
-                        graphchi_edge<EdgeDataType> * in_edge = vertex.inedge(i);
-                        int int_in_type = in_edge->get_data().old_src;
-                        incoming_label_vec.push_back(int_in_type);
-                        //logstream(LOG_INFO) << "Vertex " << vertex.id() << " getting " << int_in_type << " from in edges" << std::endl;
-                    }
-                    for (int i=0; i < vertex.num_outedges(); i++) {
-                        graphchi_edge<EdgeDataType> * out_edge = vertex.outedge(i);
-                        int int_out_type = out_edge->get_data().old_dst;
-                        outgoing_label_vec.push_back(int_out_type);
-                        //logstream(LOG_INFO) << "Vertex " << vertex.id() << " getting " << int_out_type << " from out edges" << std::endl;
-                    }
-                    std::sort(incoming_label_vec.begin(), incoming_label_vec.end());
-                    std::sort(outgoing_label_vec.begin(), outgoing_label_vec.end());
-                    
-                    int self_label = vertex.get_data();
-                    incoming_label_vec.push_back(self_label);
-                    outgoing_label_vec.push_back(self_label);
-                    
-                    std::string new_incoming_label = "";
-                    std::string first_incoming_num_string;
-                    std::stringstream first_incoming_out;
-                    first_incoming_out << *(incoming_label_vec.end() - 1);
-                    first_incoming_num_string = first_incoming_out.str();
-                    new_incoming_label += first_incoming_num_string;
-                    new_incoming_label += ",";
-                    
-                    for (std::vector<int>::iterator it = incoming_label_vec.begin(); it != incoming_label_vec.end() - 1; ++it) {
-                        std::string incoming_num_string;
-                        std::stringstream incoming_out;
-                        incoming_out << *it;
-                        incoming_num_string = incoming_out.str();
-                        new_incoming_label += incoming_num_string + " ";
-                    }
-                    
-                    std::string new_outgoing_label = "";
-                    std::string first_outgoing_num_string;
-                    std::stringstream first_outgoing_out;
-                    first_outgoing_out << *(outgoing_label_vec.end() - 1);
-                    first_outgoing_num_string = first_outgoing_out.str();
-                    new_outgoing_label += first_outgoing_num_string;
-                    new_outgoing_label += ",";
-                    
-                    for (std::vector<int>::iterator it = outgoing_label_vec.begin(); it != outgoing_label_vec.end() - 1; ++it) {
-                        std::string outgoing_num_string;
-                        std::stringstream outgoing_out;
-                        outgoing_out << *it;
-                        outgoing_num_string = outgoing_out.str();
-                        new_outgoing_label += outgoing_num_string + " ";
-                    }
-                    
-                    relabel_map_lock.lock();
-                    
-                    int label_map_label_incoming;
-                    int label_map_label_outgoing;
-                    
-                    std::pair<std::map<std::string, int>::iterator, bool> rst_temp_incoming;
-                    rst_temp_incoming = reference_map.insert(std::pair<std::string, int>(new_incoming_label, reference_map.size()));
-                    if (rst_temp_incoming.second == false) {
-                        //logstream(LOG_INFO) << "Label " + new_incoming_label + " is already in the map." << std::endl;
-                        label_map_label_incoming = rst_temp_incoming.first->second;
-                    } else {
-                        label_map_label_incoming = reference_map.size();
-                    }
-                    
-                    std::pair<std::map<std::string, int>::iterator, bool> rst_temp_outgoing;
-                    rst_temp_outgoing = reference_map.insert(std::pair<std::string, int>(new_outgoing_label, reference_map.size()));
-                    if (rst_temp_outgoing.second == false) {
-                        //logstream(LOG_INFO) << "Label " + new_outgoing_label + " is already in the map." << std::endl;
-                        label_map_label_outgoing = rst_temp_outgoing.first->second;
-                    } else {
-                        label_map_label_outgoing = reference_map.size();
-                    }
-                    
-                    relabel_map_lock.unlock();
-                    
-                    std::string new_combined_label = ""; //label_map_label_incoming,label_map_label_outgoing
-                    std::string incoming_label_in_combined;
-                    std::stringstream incoming_label_in_combined_out;
-                    incoming_label_in_combined_out << label_map_label_incoming;
-                    incoming_label_in_combined = incoming_label_in_combined_out.str();
-                    new_combined_label += incoming_label_in_combined;
-                    new_combined_label += ",";
-                    std::string outgoing_label_in_combined;
-                    std::stringstream outgoing_label_in_combined_out;
-                    outgoing_label_in_combined_out << label_map_label_outgoing;
-                    outgoing_label_in_combined = outgoing_label_in_combined_out.str();
-                    new_combined_label += outgoing_label_in_combined;
-                    
-                    relabel_map_lock.lock();
-                    
-                    int label_map_label_combined;
-                    std::pair<std::map<std::string, int>::iterator, bool> rst_temp_combined;
-                    rst_temp_combined = reference_map.insert(std::pair<std::string, int>(new_combined_label, reference_map.size()));
-                    if (rst_temp_combined.second == false) {
-                        //logstream(LOG_INFO) << "Label " + new_combined_label + " is already in the map." << std::endl;
-                        label_map_label_combined = rst_temp_combined.first->second;
-                    } else {
-                        label_map_label_combined = reference_map.size();
-                    }
-                    
-                    relabel_map_lock.unlock();
-                    
-                    label_map_lock.lock();
-                    
-                    std::pair<std::map<int, int>::iterator, bool> rst_insert;
-                    rst_insert = monitored.label_map.insert(std::pair<int, int>(label_map_label_combined, 1));
-                    if (rst_insert.second == false) {
-                        //logstream(LOG_INFO) << "Label is already in the map. Updating the value..." << std::endl;
-                        rst_insert.first->second++;
-                    }
-                    
-                    label_map_lock.unlock();
-                    vertex.set_data(label_map_label_combined);
-                    //logstream(LOG_INFO) << "The value of label " << vertex.id() << " is: " << label_map_label_combined << std::endl;
-                }
-            }
-            
-            // broadcast new label to neighbors by writing the value to the edges
-            // write to the src_type if the vertex is the source vertex of the incident edge
-            // write to the dst_type if the vertex is the destination vertex of the incident edge
-            int label = vertex.get_data();
-            if (gcontext.iteration == 0) {
-                for(int i=0; i < vertex.num_inedges(); i++) {
-                    graphchi_edge<EdgeDataType> * in_edge = vertex.inedge(i);
-                    type_label in_type = in_edge->get_data();
-                    in_type.new_dst = label;
-                    in_edge->set_data(in_type);
-                }
-                for (int i=0; i < vertex.num_outedges(); i++) {
-                    graphchi_edge<EdgeDataType> * out_edge = vertex.outedge(i);
-                    type_label out_type = out_edge->get_data();
-                    out_type.new_src = label;
-                    out_edge->set_data(out_type);
-                }
-            } else {
-                for(int i=0; i < vertex.num_inedges(); i++) {
-                    graphchi_edge<EdgeDataType> * in_edge = vertex.inedge(i);
-                    type_label in_type = in_edge->get_data();
-                    in_type.new_dst = label;
-                    in_edge->set_data(in_type);
-                    //logstream(LOG_INFO) << "Updated in edges of " << vertex.id() << " to " << in_type.old_dst << std::endl;
-                }
-                for (int i=0; i < vertex.num_outedges(); i++) {
-                    graphchi_edge<EdgeDataType> * out_edge = vertex.outedge(i);
-                    type_label out_type = out_edge->get_data();
-                    out_type.new_src = label;
-                    out_edge->set_data(out_type);
-                    //logstream(LOG_INFO) << "Updated out edges of " << vertex.id() << " to " << out_type.old_src << std::endl;
-                }
+                int vertex_type = initial_vertex_type(vertex);
+                int label_map_label = lookup_relabel(RELABEL_TYPE, &vertex_type, 1);
+                label_counts.add(label_map_label);
+                vertex.set_data(label_map_label);
+                //logstream(LOG_INFO) << "The value of label " << vertex.id() << " is: " << label_map_label << std::endl;
+            } else {//include edge type during relabeling in the second update phase (round 1)
+                int label_map_label_combined = relabel_from_edges<Keys>(vertex, round, buffers, gcontext, [this](int kind, const int * labels, size_t len) {
+                    return this->lookup_relabel(kind, labels, len);
+                });
+
+                label_counts.add(label_map_label_combined);
+                vertex.set_data(label_map_label_combined);
+                //logstream(LOG_INFO) << "The value of label " << vertex.id() << " is: " << label_map_label_combined << std::endl;
             }
+
+            broadcast_label(vertex, buffers.writes_old(round));
             /* Scheduler myself for next iteration */
             //gcontext.scheduler->add_task(vertex.id());
         }
     }
-    
+
     /**
      * Called before an iteration starts.
      */
     void before_iteration(int iteration, graphchi_context &gcontext) {
+        label_counts.reset(gcontext.execthreads);
+        if (sample.enabled())
+            sample.before_iteration(iteration, gcontext);
     }
-    
+
     /**
      * Called after an iteration has finished.
      */
-    //For debugging purpose:
     void after_iteration(int iteration, graphchi_context &gcontext) {
+        if (sample.enabled())
+            sample.after_iteration();
+        int round = sample.enabled() ? sample.round(iteration) : buffers.round(iteration);
+        if (round >= 0) {
+            std::unordered_set<int> labels;
+            label_counts.collect_labels(labels);
+            if (sample.enabled())
+                sample.end_round(0, labels.size());
+            else
+                convergence.after_round(gcontext, iteration, round, labels.size());
+        }
+        label_counts.merge_into(*label_map);
     }
-    
+
     /**
      * Called before an execution interval is started.
      */
     void before_exec_interval(vid_t window_st, vid_t window_en, graphchi_context &gcontext) {
     }
-    
+
     /**
      * Called after an execution interval has finished.
      */
     void after_exec_interval(vid_t window_st, vid_t window_en, graphchi_context &gcontext) {
     }
-    
-};
\ No newline at end of file
+
+};
+
+//run the learning program with the relabel variant of the kernelmap; in batch mode the engine runs on the graph_union batch
+struct relabel_run {
+    graphchi_engine<VertexDataType, EdgeDataType> &engine;
+    int niters;
+    const graph_union * batch;
+    size_t first_label_map;
+    edge_label_buffers buffers;
+    relabel_convergence convergence;
+    relabel_sample sample;
+    int rounds;//the rounds run
+
+    template <typename Keys>
+    void run() {
+        VertexRelabel<Keys> program;
+        program.buffers = this->buffers;
+        program.convergence = this->convergence;
+        program.sample = this->sample;
+        if (this->batch != NULL)
+            program.set_batch(this->batch, this->first_label_map);
+        if (program.sample.enabled()) {//always in the double-buffered layout, and to the last round
+            program.buffers = edge_label_buffers();
+            this->engine.run(program, program.sample.iterations((this->niters + 1) / 2));
+            KernelMaps * km = KernelMaps::get_instance();
+            for (int g = 0; g < program.sample.graphs(); g++)
+                print_sample_estimate(program.sample.finish(g, this->batch == NULL ? km->last_label_map() : km->label_map(this->first_label_map + g)));
+            this->rounds = (this->niters + 1) / 2;
+            return;
+        }
+        this->engine.run(program, this->buffers.iterations(this->niters));
+        program.convergence.report(this->engine.get_metrics(), (this->niters + 1) / 2);
+        this->rounds = (int)program.convergence.round_labels.size();
+    }
+};
+
+//niters counts iterations of the swap phase layout (see edge_label_buffers); with converge the run ends once its labels stop
+//refining (relabel_convergence). Returns the rounds run
+int run_relabel(graphchi_engine<VertexDataType, EdgeDataType> &engine, int niters, const graph_union * batch = NULL, size_t first_label_map = 0,
+                bool converge = false) {
+    relabel_convergence convergence;
+    convergence.enabled = converge;
+    relabel_run f = {engine, niters, batch, first_label_map, relabel_edge_buffers(), convergence, relabel_run_sample(), 0};
+    with_relabel_keys(KernelMaps::get_instance()->get_relabel_variant(), f);
+    return f.rounds;
+}
+
+//run the detection program with the relabel variant of the kernelmap, counting the labels into label_map
+struct relabel_detection_run {
+    graphchi_engine<VertexDataType, EdgeDataType> &engine;
+    int niters;
+    std::map<int, int> &label_map;
+    std::ostream &out;//for the estimate of a sampled run
+    edge_label_buffers buffers;
+    relabel_convergence convergence;
+    relabel_sample sample;
+
+    template <typename Keys>
+    void run() {
+        VertexRelabelDetection<Keys> program;
+        program.label_map = &this->label_map;
+        program.buffers = this->buffers;
+        program.convergence = this->convergence;
+        program.sample = this->sample;
+        if (program.sample.enabled()) {
+            program.buffers = edge_label_buffers();
+            this->engine.run(program, program.sample.iterations((this->niters + 1) / 2));
+            print_sample_estimate(program.sample.finish(0, this->label_map), this->out);
+            return;
+        }
+        this->engine.run(program, this->buffers.iterations(this->niters));
+        program.convergence.report(this->engine.get_metrics(), (this->niters + 1) / 2);
+    }
+};
+
+void run_relabel_detection(graphchi_engine<VertexDataType, EdgeDataType> &engine, int niters, std::map<int, int> &label_map,
+                           std::ostream &out = std::cout) {
+    relabel_detection_run f = {engine, niters, label_map, out, relabel_edge_buffers(), relabel_convergence(), relabel_run_sample()};
+    with_relabel_keys(KernelMaps::get_instance()->get_relabel_variant(), f);
+}
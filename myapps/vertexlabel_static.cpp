@@ -29,8 +29,6 @@
 
 using namespace graphchi;
 
-#define METRIC 0
-
 /**
  * Type definitions. Remember to create suitable graph shards using the
  * Sharder-program.
@@ -85,7 +83,8 @@ public:
     
     void print_label_map(std::map<int, int>lmap);
     
-    int calculate_kernel(std::map<int, int>& map1, std::map<int, int>& map2);
+    //metric (metric option): 0 sum of multiplication, 1 geometric distance
+    int calculate_kernel(int metric, std::map<int, int>& map1, std::map<int, int>& map2);
     
     std::map<int, int> label_map;//for the first graph
     std::map<int, int> label_map_2;//for the second graph
@@ -147,7 +146,7 @@ void KernelMaps::print_label_map (std::map<int, int>lmap) {
         logstream(LOG_INFO) << map_itr->first << ":" << map_itr->second << std::endl;
 }
 
-int KernelMaps::calculate_kernel(std::map<int, int>& map1, std::map<int, int>& map2) {
+int KernelMaps::calculate_kernel(int metric, std::map<int, int>& map1, std::map<int, int>& map2) {
     int sum = 0;
     int arr_size = 0;
     int map1_size = map1.rbegin()->first;
@@ -178,11 +177,11 @@ int KernelMaps::calculate_kernel(std::map<int, int>& map1, std::map<int, int>& m
             map2_arr.push_back(0);
         }
         //Sum of multiplication
-        if (METRIC == 0) {
+        if (metric == 0) {
             sum += map1_arr.back() * map2_arr.back();
         }
         //Sum of geometric distance SQUARED
-        else if (METRIC == 1) {
+        else if (metric == 1) {
             sum += (map1_arr.back() - map2_arr.back()) * (map1_arr.back() * map2_arr.back());
         }
     }
@@ -238,16 +237,18 @@ KernelMaps km(0);
 //for three graphs numbered 1, 2, 3, the vector contains: [1-1, 1-2, 1-3, 2-2, 2-3, 3-3].
 std::vector<int> kv;
 
-//global version macro
+//version of the relabeling
 //0: each vertex takes both incoming and outgoing neighboring vertices' labels, sorts them, and combines with its own label to relabel. No direction or edge labels considered
 //1: each vertex takes its incoming neighboring vertices' labels, sorts them, and combines with its own label to relabel. Then it takes its outgoing neighboring vertices' labels, sorts them, and combines with its own label to relabel. Then it uses these two labels, sorts them and then relabels. No edge labels considered
-#define VERSION 2
-#define TAKEEDGELABEL 0
+//2: like 1, but edge labels follow their vertex labels in the sorted arrays
+//TakeEdgeLabel: versions 0 and 1 also take the edge labels (the first time neighbor labels are gathered)
+//The version is a template argument of the programs (version and take_edge_label options), so each one has its own update
 
 /**
  * GraphChi programs need to subclass GraphChiProgram<vertex-type, edge-type>
  * class. The main logic is usually in the update function.
  */
+template <int Version, bool TakeEdgeLabel>
 struct VertexRelabel : public GraphChiProgram<VertexDataType, EdgeDataType> {
  
     //set two maps, and a counter to be in KernelMaps instance
@@ -318,14 +319,14 @@ struct VertexRelabel : public GraphChiProgram<VertexDataType, EdgeDataType> {
                     assert (vertex_label != "");
                 }
             } else {
-                if (VERSION == 0) {
+                if (Version == 0) {
                     std::vector<int> label_vec;
                     for(int i=0; i < vertex.num_inedges(); i++) {
                         graphchi_edge<EdgeDataType> * in_edge = vertex.inedge(i);
                         int int_in_type = in_edge->get_data().old_src;
                         label_vec.push_back(int_in_type);
                         logstream(LOG_INFO) << "Vertex " << vertex.id() << " getting " << int_in_type << " from in edges" << std::endl;
-                        if (TAKEEDGELABEL == 1 && gcontext.iteration == 2) {
+                        if (TakeEdgeLabel && gcontext.iteration == 2) {
                             int int_in_edge_type = in_edge->get_data().edge;
                             label_vec.push_back(int_in_edge_type);
                             logstream(LOG_INFO) << "Vertex " << vertex.id() << " getting " << int_in_edge_type << " (edge type) from in edges" << std::endl;
@@ -336,7 +337,7 @@ struct VertexRelabel : public GraphChiProgram<VertexDataType, EdgeDataType> {
                         int int_out_type = out_edge->get_data().old_dst;
                         label_vec.push_back(int_out_type);
                         logstream(LOG_INFO) << "Vertex " << vertex.id() << " getting " << int_out_type << " from out edges" << std::endl;
-                        if (TAKEEDGELABEL == 1 && gcontext.iteration == 2) {
+                        if (TakeEdgeLabel && gcontext.iteration == 2) {
                             int int_out_edge_type = out_edge->get_data().edge;
                             label_vec.push_back(int_out_edge_type);
                             logstream(LOG_INFO) << "Vertex " << vertex.id() << " getting " << int_out_edge_type << " (edge type) from in edges" << std::endl;
@@ -371,7 +372,7 @@ struct VertexRelabel : public GraphChiProgram<VertexDataType, EdgeDataType> {
                     vertex.set_data(label_map_label);
                     logstream(LOG_INFO) << "The value of label " << vertex.id() << " is: " << label_map_label << std::endl;
                 }
-                if (VERSION == 1) {
+                if (Version == 1) {
                     std::vector<int> incoming_label_vec;
                     std::vector<int> outgoing_label_vec;
                     for(int i=0; i < vertex.num_inedges(); i++) {
@@ -379,7 +380,7 @@ struct VertexRelabel : public GraphChiProgram<VertexDataType, EdgeDataType> {
                         int int_in_type = in_edge->get_data().old_src;
                         incoming_label_vec.push_back(int_in_type);
                         logstream(LOG_INFO) << "Vertex " << vertex.id() << " getting " << int_in_type << " from in edges" << std::endl;
-                        if (TAKEEDGELABEL == 1 && gcontext.iteration == 2) {
+                        if (TakeEdgeLabel && gcontext.iteration == 2) {
                             int int_in_edge_type = in_edge->get_data().edge;
                             incoming_label_vec.push_back(int_in_edge_type);
                             logstream(LOG_INFO) << "Vertex " << vertex.id() << " getting " << int_in_edge_type << " (edge type) from in edges" << std::endl;
@@ -390,7 +391,7 @@ struct VertexRelabel : public GraphChiProgram<VertexDataType, EdgeDataType> {
                         int int_out_type = out_edge->get_data().old_dst;
                         outgoing_label_vec.push_back(int_out_type);
                         logstream(LOG_INFO) << "Vertex " << vertex.id() << " getting " << int_out_type << " from out edges" << std::endl;
-                        if (TAKEEDGELABEL == 1 && gcontext.iteration == 2) {
+                        if (TakeEdgeLabel && gcontext.iteration == 2) {
                             int int_out_edge_type = out_edge->get_data().edge;
                             outgoing_label_vec.push_back(int_out_edge_type);
                             logstream(LOG_INFO) << "Vertex " << vertex.id() << " getting " << int_out_edge_type << " (edge type) from in edges" << std::endl;
@@ -463,7 +464,7 @@ struct VertexRelabel : public GraphChiProgram<VertexDataType, EdgeDataType> {
                     vertex.set_data(label_map_label_combined);
                     logstream(LOG_INFO) << "The value of label " << vertex.id() << " is: " << label_map_label_combined << std::endl;
                 }
-                if (VERSION == 2) {
+                if (Version == 2) {
                     if (gcontext.iteration == 2) {
                         std::vector<std::pair<int, int>> incoming_pair_label_vec;
                         std::vector<std::pair<int, int>> outgoing_pair_label_vec;
@@ -713,6 +714,7 @@ struct VertexRelabel : public GraphChiProgram<VertexDataType, EdgeDataType> {
     
 };
 
+template <int Version, bool TakeEdgeLabel>
 struct VertexRelabel2 : public GraphChiProgram<VertexDataType, EdgeDataType> {
 
     std::mutex relabel_map_lock;
@@ -777,14 +779,14 @@ struct VertexRelabel2 : public GraphChiProgram<VertexDataType, EdgeDataType> {
                     assert (vertex_label != "");
                 }
             } else {
-                if (VERSION == 0) {
+                if (Version == 0) {
                     std::vector<int> label_vec;
                     for(int i=0; i < vertex.num_inedges(); i++) {
                         graphchi_edge<EdgeDataType> * in_edge = vertex.inedge(i);
                         int int_in_type = in_edge->get_data().old_src;
                         label_vec.push_back(int_in_type);
                         logstream(LOG_INFO) << "Vertex " << vertex.id() << " getting " << int_in_type << " from in edges" << std::endl;
-                        if (TAKEEDGELABEL == 1 && gcontext.iteration == 2) {
+                        if (TakeEdgeLabel && gcontext.iteration == 2) {
                             int int_in_edge_type = in_edge->get_data().edge;
                             label_vec.push_back(int_in_edge_type);
                             logstream(LOG_INFO) << "Vertex " << vertex.id() << " getting " << int_in_edge_type << " (edge type) from in edges" << std::endl;
@@ -795,7 +797,7 @@ struct VertexRelabel2 : public GraphChiProgram<VertexDataType, EdgeDataType> {
                         int int_out_type = out_edge->get_data().old_dst;
                         label_vec.push_back(int_out_type);
                         logstream(LOG_INFO) << "Vertex " << vertex.id() << " getting " << int_out_type << " from out edges" << std::endl;
-                        if (TAKEEDGELABEL == 1 && gcontext.iteration == 2) {
+                        if (TakeEdgeLabel && gcontext.iteration == 2) {
                             int int_out_edge_type = out_edge->get_data().edge;
                             label_vec.push_back(int_out_edge_type);
                             logstream(LOG_INFO) << "Vertex " << vertex.id() << " getting " << int_out_edge_type << " (edge type) from in edges" << std::endl;
@@ -830,7 +832,7 @@ struct VertexRelabel2 : public GraphChiProgram<VertexDataType, EdgeDataType> {
                     vertex.set_data(label_map_label);
                     logstream(LOG_INFO) << "The value of label " << vertex.id() << " is: " << label_map_label << std::endl;
                 }
-                if (VERSION == 1) {
+                if (Version == 1) {
                     std::vector<int> incoming_label_vec;
                     std::vector<int> outgoing_label_vec;
                     for(int i=0; i < vertex.num_inedges(); i++) {
@@ -838,7 +840,7 @@ struct VertexRelabel2 : public GraphChiProgram<VertexDataType, EdgeDataType> {
                         int int_in_type = in_edge->get_data().old_src;
                         incoming_label_vec.push_back(int_in_type);
                         logstream(LOG_INFO) << "Vertex " << vertex.id() << " getting " << int_in_type << " from in edges" << std::endl;
-                        if (TAKEEDGELABEL == 1 && gcontext.iteration == 2) {
+                        if (TakeEdgeLabel && gcontext.iteration == 2) {
                             int int_in_edge_type = in_edge->get_data().edge;
                             incoming_label_vec.push_back(int_in_edge_type);
                             logstream(LOG_INFO) << "Vertex " << vertex.id() << " getting " << int_in_edge_type << " (edge type) from in edges" << std::endl;
@@ -849,7 +851,7 @@ struct VertexRelabel2 : public GraphChiProgram<VertexDataType, EdgeDataType> {
                         int int_out_type = out_edge->get_data().old_dst;
                         outgoing_label_vec.push_back(int_out_type);
                         logstream(LOG_INFO) << "Vertex " << vertex.id() << " getting " << int_out_type << " from out edges" << std::endl;
-                        if (TAKEEDGELABEL == 1 && gcontext.iteration == 2) {
+                        if (TakeEdgeLabel && gcontext.iteration == 2) {
                             int int_out_edge_type = out_edge->get_data().edge;
                             outgoing_label_vec.push_back(int_out_edge_type);
                             logstream(LOG_INFO) << "Vertex " << vertex.id() << " getting " << int_out_edge_type << " (edge type) from in edges" << std::endl;
@@ -922,7 +924,7 @@ struct VertexRelabel2 : public GraphChiProgram<VertexDataType, EdgeDataType> {
                     vertex.set_data(label_map_label_combined);
                     logstream(LOG_INFO) << "The value of label " << vertex.id() << " is: " << label_map_label_combined << std::endl;
                 }
-                if (VERSION == 2) {
+                if (Version == 2) {
                     if (gcontext.iteration == 2) {
                         std::vector<std::pair<int, int>> incoming_pair_label_vec;
                         std::vector<std::pair<int, int>> outgoing_pair_label_vec;
@@ -1170,6 +1172,35 @@ struct VertexRelabel2 : public GraphChiProgram<VertexDataType, EdgeDataType> {
     
 };
 
+//relabel the first graph (into label_map) and the second one (into label_map_2) with the given version
+template <int Version, bool TakeEdgeLabel>
+void relabel_pair(const std::string& filename, int nshards, const std::string& filename2, int nshards2, int niters, bool scheduler, metrics& m) {
+    VertexRelabel<Version, TakeEdgeLabel> program;
+    graphchi_engine<VertexDataType, EdgeDataType> engine(filename, nshards, scheduler, m);
+    engine.run(program, niters);
+    
+    VertexRelabel2<Version, TakeEdgeLabel> program2;
+    graphchi_engine<VertexDataType, EdgeDataType> engine2(filename2, nshards2, scheduler, m);
+    engine2.run(program2, niters);
+}
+
+void relabel_pair(int version, bool take_edge_label, const std::string& filename, int nshards, const std::string& filename2, int nshards2, int niters, bool scheduler, metrics& m) {
+    if (version == 0 && !take_edge_label)
+        relabel_pair<0, false>(filename, nshards, filename2, nshards2, niters, scheduler, m);
+    else if (version == 0)
+        relabel_pair<0, true>(filename, nshards, filename2, nshards2, niters, scheduler, m);
+    else if (version == 1 && !take_edge_label)
+        relabel_pair<1, false>(filename, nshards, filename2, nshards2, niters, scheduler, m);
+    else if (version == 1)
+        relabel_pair<1, true>(filename, nshards, filename2, nshards2, niters, scheduler, m);
+    else if (version == 2)//always takes the edge labels
+        relabel_pair<2, false>(filename, nshards, filename2, nshards2, niters, scheduler, m);
+    else {
+        logstream(LOG_FATAL) << "Unknown version " << version << " (0, 1 or 2)" << std::endl;
+        assert(false);
+    }
+}
+
 int main(int argc, const char ** argv) {
     /* GraphChi initialization will read the command line
      arguments and the configuration file. */
@@ -1200,6 +1231,10 @@ int main(int argc, const char ** argv) {
     //bool scheduler       = get_option_int("scheduler", 0); // Whether to use selective scheduling
     //TODO: should I use selective scheduling?
     bool scheduler       = false;
+    //relabeling variant and metric (see VertexRelabel and KernelMaps::calculate_kernel)
+    int version          = get_option_int("version", 2);
+    bool take_edge_label = get_option_int("take_edge_label", 0) != 0;
+    int metric           = get_option_int("metric", 0);
     
     /* Detect the number of shards or preprocess an input to create them */
     //for each file, detect shards or preprocess an input to create them
@@ -1220,16 +1255,10 @@ int main(int argc, const char ** argv) {
     //modify this code and resetMaps code to streamline
     for (int i = 0 ; i < num_graphs; i++) {
         for (int j = 0; j < num_graphs - i; j++) {
-            VertexRelabel program;
-            graphchi_engine<VertexDataType, EdgeDataType> engine(filenames[i], nshards_arr[i], scheduler, m);
-            engine.run(program, niters);
-            
-            VertexRelabel2 program2;
-            graphchi_engine<VertexDataType, EdgeDataType> engine2(filenames[i+j], nshards_arr[i+j], scheduler, m);
-            engine2.run(program2, niters);
+            relabel_pair(version, take_edge_label, filenames[i], nshards_arr[i], filenames[i+j], nshards_arr[i+j], niters, scheduler, m);
             
             //calculate the kernel value between two graphs
-            int k_value = km.calculate_kernel(km.label_map, km.label_map_2);
+            int k_value = km.calculate_kernel(metric, km.label_map, km.label_map_2);
             //reset the maps for next iteration
             km.resetMaps(0);
             //push the kernel value into the global kv vector
@@ -1248,7 +1277,7 @@ int main(int argc, const char ** argv) {
     //produce normalized kernel value for each graph
     double normalized_kv[num_graphs] = {};
     //sum of multiplication
-    if (METRIC == 0) {
+    if (metric == 0) {
         for (int i = 0; i < num_graphs; i++) {
             double total = 0.0;
             for (int j = 0; j < num_graphs; j++) {
@@ -1262,7 +1291,7 @@ int main(int argc, const char ** argv) {
             }
             normalized_kv[i] = total/num_graphs;
         }
-    } else if (METRIC == 1) {//geometric distance
+    } else if (metric == 1) {//geometric distance
         for (int i = 0; i < num_graphs; i++) {
             double total = 0.0;
             for (int j = 0; j < num_graphs; j++) {
@@ -33,6 +33,7 @@
 #define DEF_GRAPHCHI_CONTEXT
 
 #include <vector>
+#include <memory>
 #include <assert.h>
 #include <omp.h>
 #include <sys/time.h>
@@ -42,6 +43,42 @@
 
 namespace graphchi {
     
+    /**
+      * Temporary arrays of one update thread, kept from one update to the next
+      * so that an update function can collect (and sort) the labels of the
+      * neighbors of a vertex without allocating memory on every call.
+      * A slot holds a vector of the type it is first asked for, and keeps
+      * its capacity when it is handed out again.
+      */
+    class scratch_arena {
+        struct slot_base {
+            virtual ~slot_base() {}
+        };
+        
+        template <typename T>
+        struct slot : public slot_base {
+            std::vector<T> items;
+        };
+        
+        std::vector<std::unique_ptr<slot_base> > slots;
+        
+    public:
+        
+        /**
+          * The (emptied) vector in slot index. A slot must always be asked
+          * for with the same type.
+          */
+        template <typename T>
+        std::vector<T> & get(size_t index) {
+            if (index >= slots.size()) slots.resize(index + 1);
+            if (!slots[index]) slots[index].reset(new slot<T>());
+            assert(dynamic_cast<slot<T> *>(slots[index].get()) != NULL);
+            std::vector<T> & items = static_cast<slot<T> *>(slots[index].get())->items;
+            items.clear();
+            return items;
+        }
+    };
+    
     struct graphchi_context {
 
         size_t nvertices;
@@ -53,6 +90,7 @@ namespace graphchi {
         int last_iteration;
         int execthreads;
         std::vector<double> deltas;
+        std::vector<scratch_arena> scratch_arenas;
         timeval start;
         std::string filename;
         double last_deltasum;
@@ -79,6 +117,34 @@ namespace graphchi {
             deltas = std::vector<double>(nthreads, 0.0);
         }
         
+        /**
+          * Make sure there is a scratch arena for every update thread:
+          * nthreads for the threads of the nested parallel for of
+          * graphchi_engine::exec_updates, and one for the section that
+          * runs the vertices that are not parallel safe next to it.
+          * Arenas are kept between iterations (and runs), so that their
+          * buffers are allocated once.
+          */
+        void reserve_scratch(int nthreads) {
+            if ((int)scratch_arenas.size() < nthreads + 1)
+                scratch_arenas.resize(nthreads + 1);
+        }
+        
+        /**
+          * Scratch arena of the calling update thread. Threads of the
+          * nested parallel for are numbered in their own team; any other
+          * caller (the serial section, or code outside a parallel region)
+          * gets the last arena.
+          */
+        scratch_arena & scratch() {
+            assert(!scratch_arenas.empty());
+            if (omp_get_level() > 1) {
+                assert(omp_get_thread_num() + 1 < (int)scratch_arenas.size());
+                return scratch_arenas[omp_get_thread_num()];
+            }
+            return scratch_arenas.back();
+        }
+        
         double get_delta() {
             double d = 0.0;
             for(int i=0; i < (int)deltas.size(); i++) {
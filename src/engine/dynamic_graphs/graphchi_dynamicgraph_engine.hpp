@@ -90,6 +90,14 @@ namespace graphchi {
             return true;
         }
         
+        /**
+         * In-memory mode loads the vertices once for all iterations,
+         * so it would never see the new edges.
+         */
+        virtual bool is_inmemory_mode() {
+            return false;
+        }
+        
         /** 
           * Create a dynamic version of the degree file.
           */
@@ -794,6 +794,7 @@ namespace graphchi {
                 
                 chicontext.execthreads = exec_threads;
                 chicontext.reset_deltas(exec_threads);
+                chicontext.reserve_scratch(exec_threads);
                 
                 /* Call iteration-begin event handler */
                 userprogram.before_iteration(iter, chicontext);
@@ -1036,6 +1037,13 @@ namespace graphchi {
             return membudget_mb;
         }
         
+        /**
+         * Metrics the engine reports to, for programs that add their own.
+         */
+        metrics & get_metrics() {
+            return m;
+        }
+        
         void set_load_threads(int lt) {
             load_threads = lt;
         }
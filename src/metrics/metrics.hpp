@@ -327,6 +327,21 @@ namespace graphchi {
       return entries[key];
     }
       
+    /**
+     * Copy the entries of another metrics instance, with prefix prepended
+     * to their keys. For instances that were filled in parallel (their
+     * timers cannot be shared), to be reported with this one.
+     */
+    inline void add_entries(metrics & other, std::string prefix) {
+        other.mlock.lock();
+        std::map<std::string, metrics_entry> copied = other.entries;
+        other.mlock.unlock();
+        mlock.lock();
+        for (std::map<std::string, metrics_entry>::iterator it = copied.begin(); it != copied.end(); ++it)
+            entries[prefix + it->first] = it->second;
+        mlock.unlock();
+    }
+      
       
     void report(imetrics_reporter & reporter) {
           if (name != "") {
@@ -26,6 +26,7 @@
 
 #include <algorithm>
 #include <vector>
+#include <functional>
 
 template <class E, class BinPred>
 void insertionSort(E* A, int n, BinPred f) {
@@ -40,6 +41,14 @@ void insertionSort(E* A, int n, BinPred f) {
 
 #define ISORT 25
 
+// Sort of a short array, such as the neighbor labels of a low degree vertex:
+// insertion sort up to ISORT elements (no recursion or pivot selection), std::sort above.
+template <class E>
+void smallSort(E* A, int n) {
+    if (n <= ISORT) insertionSort(A, n, std::less<E>());
+    else std::sort(A, A + n);
+}
+
 template <class E, class BinPred>
 E median(E a, E b, E c, BinPred f) {
     return  f(a,b) ? (f(b,c) ? b : (f(a,c) ? c : a)) 